@@ -23,6 +23,8 @@
  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "td512.h" // td512 functions
+#include "tdKeys.h" // tdKeys functions
+#include "tdTiny.h" // tdTiny functions
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,7 +45,7 @@ int32_t test_td512_1to512(void)
 {
     // generate data then run through compress and decompress and compare for 1 to 512 values
     unsigned char textData[512]={"it over afterwards, it occurred to her that she ought to have wondered at this, but at the time it all seemed quite natural); but when the Rabbit actually TOOK A WATCH OUT OF ITS WAISTCOAT- POCKET, and looked at it, and then hurried on, Alice started to her feet, for it flashed across her mind that she had never before seen a rabbit with either a waistcoat-pocket, or a watch to take out of it, and burning with curiosity, she ran across the field after it, and fortunately was just in time to see it positive"};
-    unsigned char textOut[515];
+    unsigned char textOut[TD512_MAX_OUTPUT_BYTES];
     unsigned char textOrig[512];
     uint32_t bytesProcessed;
     int32_t retVal;
@@ -75,6 +77,247 @@ RUN_512:
     return 0;
 }
 
+int32_t test_td512_ctx_65to512(void)
+{
+    // compress and decompress random values and text with high-bit values for 65 to 512 values with a dictionary,
+    // and in stream mode
+    unsigned char dictData[]={"it over afterwards, it occurred to her that she ought to have wondered at this, but at the time it all seemed quite natural"};
+    unsigned char inData[512];
+    unsigned char outData[TD512_MAX_OUTPUT_BYTES];
+    unsigned char origData[512];
+    td512ctx ctx;
+    td512ctx dctx;
+    uint32_t bytesProcessed;
+    uint32_t seed=12345;
+    int32_t retVal;
+    int blockNum;
+    int streamMode;
+    int i;
+    int j;
+    for (blockNum=0; blockNum<72; blockNum++)
+    {
+        for (i=0; i<512; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            if (blockNum >= 64)
+                inData[i] = (unsigned char)(seed >> 16); // random values
+            else if ((seed >> 16) & 1)
+                inData[i] = dictData[i % (sizeof(dictData)-1)];
+            else
+                inData[i] = (unsigned char)(0x80 | (seed >> 19)); // text with high-bit values, which td512 may output as more bytes than values
+        }
+        for (i=65; i<=512; i++)
+        {
+            for (streamMode=0; streamMode<2; streamMode++)
+            {
+                if (streamMode)
+                {
+                    // the second block is encoded in the mode carried from the first and with it as the window
+                    td512InitStreamCtx(&ctx);
+                    td512InitStreamCtx(&dctx);
+                    td512SetStreamWindow(&ctx, 512);
+                    td512SetStreamWindow(&dctx, 512);
+                }
+                else
+                {
+                    td512InitCtx(&ctx);
+                    td512InitCtx(&dctx);
+                }
+                td512LoadDictionary(&ctx, dictData, sizeof(dictData)-1);
+                td512LoadDictionary(&dctx, dictData, sizeof(dictData)-1);
+                for (j=0; j<=streamMode; j++)
+                {
+                    retVal = td512_ctx(&ctx, inData, outData, i);
+                    if (retVal < 0)
+                        return i;
+                    retVal = td512d_ctx(&dctx, outData, origData, &bytesProcessed);
+                    if (retVal != i)
+                        return -i;
+                    if (memcmp(inData, origData, i) != 0)
+                        return 1000+i;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int32_t test_td512d_prefix(void)
+{
+    // decode every prefix of text compressed for 1 to 512 values, which includes text and bigram codes cut by the prefix
+    unsigned char textData[512]={"it over afterwards, it occurred to her that she ought to have wondered at this, but at the time it all seemed quite natural); but when the Rabbit actually TOOK A WATCH OUT OF ITS WAISTCOAT- POCKET, and looked at it, and then hurried on, Alice started to her feet, for it flashed across her mind that she had never before seen a rabbit with either a waistcoat-pocket, or a watch to take out of it, and burning with curiosity, she ran across the field after it, and fortunately was just in time to see it positive"};
+    unsigned char textOut[TD512_MAX_OUTPUT_BYTES];
+    unsigned char textOrig[512];
+    int32_t retVal;
+    int i;
+    int j;
+    for (i=1; i<=512; i++)
+    {
+        retVal = td512(textData, textOut, i);
+        if (retVal < 0)
+            return i;
+        for (j=1; j<=i; j++)
+        {
+            retVal = td512d_prefix(textOut, textOrig, j);
+            if (retVal != j)
+                return -i;
+            if (memcmp(textData, textOrig, j) != 0)
+                return 1000+i;
+        }
+    }
+    return 0;
+}
+
+int32_t test_td512_max(void)
+{
+    // compress text and random values for 1 to 512 values into exactly the bytes td512 outputs, which must give the same
+    // bytes, and into one byte less, which must return -151
+    unsigned char textData[512]={"it over afterwards, it occurred to her that she ought to have wondered at this, but at the time it all seemed quite natural); but when the Rabbit actually TOOK A WATCH OUT OF ITS WAISTCOAT- POCKET, and looked at it, and then hurried on, Alice started to her feet, for it flashed across her mind that she had never before seen a rabbit with either a waistcoat-pocket, or a watch to take out of it, and burning with curiosity, she ran across the field after it, and fortunately was just in time to see it positive"};
+    unsigned char textOut[TD512_MAX_OUTPUT_BYTES];
+    unsigned char maxOut[TD512_MAX_OUTPUT_BYTES];
+    uint32_t seed=12345;
+    int32_t nOutBytes;
+    int32_t retVal;
+    int pass;
+    int i;
+    for (pass=0; pass<2; pass++)
+    {
+        if (pass)
+        {
+            for (i=0; i<512; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                textData[i] = (unsigned char)(seed >> 16); // random values
+            }
+        }
+        for (i=1; i<=512; i++)
+        {
+            nOutBytes = td512(textData, textOut, i);
+            if (nOutBytes < 0)
+                return i;
+            retVal = td512_max(textData, maxOut, i, nOutBytes);
+            if (retVal != nOutBytes || memcmp(textOut, maxOut, nOutBytes) != 0)
+                return -i;
+            if (td512_max(textData, maxOut, i, nOutBytes-1) != -151)
+                return 1000+i;
+        }
+    }
+    return 0;
+}
+
+int32_t test_tdKeys(void)
+{
+    // encode keys of 4 to 40 bytes with shared prefixes for restart intervals of 1 to 128 into exactly the bytes
+    // output, which must give the same bytes, and into one byte less, which must return -143, then decode and get every key
+    unsigned char textData[]={"it over afterwards, it occurred to her that she ought to have wondered at this, but at the time it all seemed quite natural"};
+    const uint32_t restartIntervals[]={1, 3, 16, 128};
+    unsigned char keyVals[300*40];
+    uint32_t keySizes[300];
+    unsigned char keysOut[300*48];
+    unsigned char maxOut[300*48];
+    unsigned char decodedVals[300*40];
+    uint32_t decodedSizes[300];
+    unsigned char keyVal[TDKEYS_MAX_KEY_BYTES];
+    const uint32_t nKeys=300;
+    uint32_t keyValsOffset=0;
+    int32_t nOutBytes;
+    int32_t retVal;
+    uint32_t ri;
+    uint32_t i;
+    for (i=0; i<nKeys; i++)
+    {
+        // 4 digits of i/4, so that 4 keys in a row share the prefix, followed by 0 to 36 bytes of text
+        keySizes[i] = 4 + (i * 13) % 37;
+        keyVals[keyValsOffset] = (unsigned char)('0' + i / 4000);
+        keyVals[keyValsOffset+1] = (unsigned char)('0' + i / 400 % 10);
+        keyVals[keyValsOffset+2] = (unsigned char)('0' + i / 40 % 10);
+        keyVals[keyValsOffset+3] = (unsigned char)('0' + i / 4 % 10);
+        memcpy(keyVals+keyValsOffset+4, textData+i%64, keySizes[i]-4);
+        keyValsOffset += keySizes[i];
+    }
+    for (ri=0; ri<sizeof(restartIntervals)/sizeof(restartIntervals[0]); ri++)
+    {
+        nOutBytes = tdKeysEncode(keyVals, keySizes, nKeys, restartIntervals[ri], keysOut, sizeof(keysOut));
+        if (nOutBytes < 0)
+            return 1+(int32_t)ri;
+        memset(maxOut, 0x5a, sizeof(maxOut));
+        retVal = tdKeysEncode(keyVals, keySizes, nKeys, restartIntervals[ri], maxOut, (uint32_t)nOutBytes);
+        if (retVal != nOutBytes || memcmp(keysOut, maxOut, nOutBytes) != 0 || maxOut[nOutBytes] != 0x5a)
+            return 10+(int32_t)ri;
+        if (tdKeysEncode(keyVals, keySizes, nKeys, restartIntervals[ri], maxOut, (uint32_t)nOutBytes-1) != -143)
+            return 20+(int32_t)ri;
+        if (tdKeysDecode(keysOut, decodedVals, sizeof(decodedVals), decodedSizes, nKeys) != (int32_t)nKeys)
+            return 30+(int32_t)ri;
+        if (memcmp(keySizes, decodedSizes, nKeys*sizeof(keySizes[0])) != 0 || memcmp(keyVals, decodedVals, keyValsOffset) != 0)
+            return 40+(int32_t)ri;
+        keyValsOffset = 0;
+        for (i=0; i<nKeys; i++)
+        {
+            retVal = tdKeysGet(keysOut, i, keyVal);
+            if (retVal != (int32_t)keySizes[i] || memcmp(keyVals+keyValsOffset, keyVal, keySizes[i]) != 0)
+                return 1000+(int32_t)i;
+            keyValsOffset += keySizes[i];
+        }
+    }
+    return 0;
+}
+
+int32_t test_tdTiny(void)
+{
+    // encode text and random values of mixed sizes from 1 to 15 bytes, and of one size, into exactly the bytes output,
+    // which must give the same bytes, and into one byte less, which must return -149, then decode them
+    unsigned char textData[]={"it over afterwards, it occurred to her that she ought to have wondered at this, but at the time it all seemed quite natural"};
+    unsigned char inVals[TDTINY_MAX_VALUES*TDTINY_MAX_VALUE_BYTES];
+    uint32_t valSizes[TDTINY_MAX_VALUES];
+    unsigned char tinyOut[TDTINY_MAX_VALUES*(TDTINY_MAX_VALUE_BYTES+1)+TD512_MAX_OUTPUT_BYTES];
+    unsigned char maxOut[TDTINY_MAX_VALUES*(TDTINY_MAX_VALUE_BYTES+1)+TD512_MAX_OUTPUT_BYTES];
+    unsigned char decodedVals[TDTINY_MAX_VALUES*TDTINY_MAX_VALUE_BYTES];
+    uint32_t decodedSizes[TDTINY_MAX_VALUES];
+    const uint32_t nValsList[]={1, 2, 7, 100, TDTINY_MAX_VALUES};
+    uint32_t seed=12345;
+    uint32_t bytesProcessed;
+    uint32_t nInVals;
+    int32_t nOutBytes;
+    int32_t retVal;
+    uint32_t pass;
+    uint32_t ni;
+    uint32_t i;
+    uint32_t j;
+    for (pass=0; pass<4; pass++)
+    {
+        for (ni=0; ni<sizeof(nValsList)/sizeof(nValsList[0]); ni++)
+        {
+            const uint32_t nVals=nValsList[ni];
+            nInVals = 0;
+            for (i=0; i<nVals; i++)
+            {
+                // passes 0 and 1 are text and random values of mixed sizes, 2 and 3 of 3 and 12 bytes
+                seed = seed * 1103515245 + 12345;
+                valSizes[i] = pass < 2 ? 1 + (seed >> 16) % TDTINY_MAX_VALUE_BYTES : (pass == 2 ? 3 : 12);
+                for (j=0; j<valSizes[i]; j++)
+                {
+                    seed = seed * 1103515245 + 12345;
+                    inVals[nInVals++] = pass == 1 ? (unsigned char)(seed >> 16) : textData[(i*7+j) % (sizeof(textData)-1)];
+                }
+            }
+            nOutBytes = tdTinyEncode(inVals, valSizes, nVals, tinyOut, sizeof(tinyOut));
+            if (nOutBytes < 0)
+                return 1+(int32_t)(pass*10+ni);
+            memset(maxOut, 0x5a, sizeof(maxOut));
+            retVal = tdTinyEncode(inVals, valSizes, nVals, maxOut, (uint32_t)nOutBytes);
+            if (retVal != nOutBytes || memcmp(tinyOut, maxOut, nOutBytes) != 0 || maxOut[nOutBytes] != 0x5a)
+                return 100+(int32_t)(pass*10+ni);
+            if (tdTinyEncode(inVals, valSizes, nVals, maxOut, (uint32_t)nOutBytes-1) != -149)
+                return 200+(int32_t)(pass*10+ni);
+            if (tdTinyDecode(tinyOut, decodedVals, decodedSizes, &bytesProcessed) != (int32_t)nVals || bytesProcessed != (uint32_t)nOutBytes)
+                return 300+(int32_t)(pass*10+ni);
+            if (memcmp(valSizes, decodedSizes, nVals*sizeof(valSizes[0])) != 0 || memcmp(inVals, decodedVals, nInVals) != 0)
+                return 400+(int32_t)(pass*10+ni);
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     FILE *ifile, *ofile;
@@ -103,6 +346,31 @@ int main(int argc, char* argv[])
         printf("error from test_td512_1to512=%d\n", retVal);
         return -83;
     }
+    if ((retVal=test_td512_ctx_65to512()) != 0) // do check of 65 to 512 values with a dictionary
+    {
+        printf("error from test_td512_ctx_65to512=%d\n", retVal);
+        return -84;
+    }
+    if ((retVal=test_td512d_prefix()) != 0) // do check of every prefix of 1 to 512 values
+    {
+        printf("error from test_td512d_prefix=%d\n", retVal);
+        return -85;
+    }
+    if ((retVal=test_td512_max()) != 0) // do check of 1 to 512 values into exactly the bytes output and one byte less
+    {
+        printf("error from test_td512_max=%d\n", retVal);
+        return -86;
+    }
+    if ((retVal=test_tdKeys()) != 0) // do check of keys into exactly the bytes output and one byte less
+    {
+        printf("error from test_tdKeys=%d\n", retVal);
+        return -87;
+    }
+    if ((retVal=test_tdTiny()) != 0) // do check of values into exactly the bytes output and one byte less
+    {
+        printf("error from test_tdTiny=%d\n", retVal);
+        return -88;
+    }
     printf("TEST_TD512 passed\n");
 #endif
     if (argc < 2)
@@ -21,6 +21,7 @@
  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include "td512.h"
+#include "td64_internal.h"
 #include "string.h"
 
 #ifdef TD512_TEST_MODE
@@ -49,30 +50,59 @@ const uint32_t textChars[256]={
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
-uint32_t checktd64(const unsigned char *inVals, unsigned char *tempOutVals)
+uint32_t checktd64(const unsigned char *inVals, unsigned char *tempOutVals, td64Analysis *analysis, const int32_t tableId)
 {
+    // text characters are those of registered table tableId, or of the predefined tables when tableId is -1
     // return 0 to select extended string mode
-    //        1 to select td64
+    //        1 to select td64 with analysis of the first 64 values for td64Analyzed
     //        2 to select td64 after processing first 64 as random
-    uint8_t val256[256]={0};
+    uint8_t *val256=analysis->val256;
     uint8_t count[MAX_TD64_BYTES]={0};
     uint32_t highBitCheck=0;
+    uint32_t predefinedTextCharCnt=0;
+    uint32_t nUniqueVals=0;
+    int32_t singleValue=-1;
+    const uint32_t minRepeatsSingleValueMode=18;
     uint32_t i=0;
     
+    const uint32_t *textCharBits=td64TextCharBits(tableId);
+    
+    analysis->tableId = tableId;
+    memset(val256, 0, 256);
     while (i < 28)
     {
         // accumulate counts of uniques
         const uint32_t inVal=inVals[i++];
+        predefinedTextCharCnt += textCharBits[inVal];
+        if (val256[inVal] == 0)
+        {
+            analysis->uniqueOccurrence[inVal] = nUniqueVals;
+            analysis->uniques[nUniqueVals++] = (unsigned char)inVal;
+        }
         count[val256[inVal]++]++;
         highBitCheck |= inVal;
     }
     if (count[0] > 24 && highBitCheck & 0x80)
         return 2; // assume random and process first 64 as such
+    analysis->nUniqueValsInitLoop = nUniqueVals;
+    analysis->highBitCheckInitLoop = highBitCheck;
+    analysis->predefinedTextCharCnt = predefinedTextCharCnt;
     while (i < 64)
     {
         const uint32_t inVal=inVals[i++];
+        if (val256[inVal] == 0)
+        {
+            analysis->uniqueOccurrence[inVal] = nUniqueVals;
+            analysis->uniques[nUniqueVals++] = (unsigned char)inVal;
+        }
+        else if (singleValue < 0 && val256[inVal] >= minRepeatsSingleValueMode-1)
+            singleValue = (int32_t)inVal;
         count[val256[inVal]++]++;
+        highBitCheck |= inVal;
     }
+    analysis->nUniqueVals = nUniqueVals;
+    analysis->highBitCheck = highBitCheck;
+    analysis->singleValue = singleValue;
     if (count[0] > 40)
         return 1; // more uniques than usually compress
     if (count[0] <= 2)
@@ -81,23 +111,22 @@ uint32_t checktd64(const unsigned char *inVals, unsigned char *tempOutVals)
     {
         return 1; // fine line between choosing td64 and extended string mode as shown between files mr and nci, for high counts of a repeated value
     }
-    const uint32_t minRepeatsSingleValueMode=18;
     if (count[minRepeatsSingleValueMode] && count[0] >  MIN_UNIQUES_SINGLE_VALUE_MODE_CHECK)
     {
         // single value mode works for up to 46 uniques, but files with repeating values, such as paper-100k.pdf, compress better using string mode
         int32_t retBits;
         int32_t retBitstd64;
         uint32_t nValuesRead;
-        retBits = encodeExtendedStringMode(inVals, tempOutVals, 64, &nValuesRead);
+        retBits = encodeExtendedStringModeMax(inVals, tempOutVals, 64, &nValuesRead, MAX_TD64_BYTES, 1); // only the size is compared
         if (retBits <= 0)
-            return 1; // process this block with td64
-        if (retBits+16 > (retBitstd64=td64(inVals, tempOutVals, 64)))
+            return 1; // process this block with td64, also when string mode does not fit in tempOutVals
+        if (retBits+16 > (retBitstd64=td64Analyzed(inVals, tempOutVals, 64, analysis)))
             return retBitstd64; // pick td64 if string mode is less than 3% better  and return compressed values
     }
     return 0;
 } // end checktd64
 
-uint32_t checkTextMode(const unsigned char *inVals, uint32_t nValues, uint32_t *highBitCheck)
+uint32_t checkTextMode(const unsigned char *inVals, uint32_t nValues, uint32_t *highBitCheck, const int32_t tableId)
 {
     // try to determine whether this data should be compressed with extended text mode
     // return 0 to skip text mode
@@ -110,13 +139,14 @@ uint32_t checkTextMode(const unsigned char *inVals, uint32_t nValues, uint32_t *
     uint32_t predefinedCharCount=0;
     uint32_t thisHighBitCheck=0;
     uint32_t i=0;
+    const uint32_t *textCharBits=td64TextCharBits(tableId); // predefined or registered text table chars
     
     while (i<8)
     {
         const uint32_t inVal=inVals[i++];
         thisHighBitCheck += inVal & 0x80;
         charCount += textChars[inVal];
-        predefinedCharCount += predefinedBitTextChars[inVal];
+        predefinedCharCount += textCharBits[inVal];
     }
     if (thisHighBitCheck > 0x80)
         return 0; // allow only 1 extended text character
@@ -125,7 +155,7 @@ uint32_t checkTextMode(const unsigned char *inVals, uint32_t nValues, uint32_t *
     {
         const uint32_t inVal=inVals[i++];
         charCount += textChars[inVal];
-        predefinedCharCount += predefinedBitTextChars[inVal];
+        predefinedCharCount += textCharBits[inVal];
         thisHighBitCheck |= inVal;
     }
     if (charCount < 90)
@@ -143,12 +173,157 @@ uint32_t checkTextMode(const unsigned char *inVals, uint32_t nValues, uint32_t *
     return 1;
 } // end checkTextMode
 
-int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+static inline void td512OutputInfoBytes(unsigned char *outVals, const uint32_t nValues, const uint32_t extendedMode, const uint32_t passFail)
+{
+    // process info bytes for 65 to 512 values
+    if (nValues <= 320)
+    {
+        // nValues 65 to 320, excess 65 value
+        outVals[0] = (unsigned char)((nValues-65) << 2) | 1; // indicator of 65 to 320 values, and lower 6 bits of 8-bit excess 65 value
+        outVals[1] |= (unsigned char)((nValues-65)>>6) & 3; // upper 2 bits of value
+    }
+    else
+    {
+        // nValues 321 to 512, excess 321 value
+        outVals[0] = (unsigned char)((nValues-321) << 2) | 3; // indicator of 321 to 512 values, and lower 6 bits of 8-bit excess 321 value
+        outVals[1] |= (unsigned char)((nValues-321)>>6) & 3; // upper 2 bits of value; string mode uses third bit for 9th bit of string count; for <=256 values, upper four bits are pass/fail
+    }
+    // two bits indicates how compression starts; extended modes for >= 128 values continue with td64 for any remaining values
+    // 0 td64
+    // 1 extended text mode
+    // 2 extended string mode
+    // 3 extension selected by the byte following the info bytes (TD512_EXT_...)
+    outVals[1] |= extendedMode << 2; // used for >= 128 values
+    if (nValues <= 256)
+    {
+        outVals[1] |= passFail << 4; // use upper four bits of second info byte
+    }
+    else
+    {
+        outVals[2] = passFail; // use third info byte
+    }
+} // end td512OutputInfoBytes
+
+static uint32_t countSharedUniques(const unsigned char *inVals, const uint32_t nValues, unsigned char *sharedUniques, uint32_t *sharedOccurrence)
+{
+    // return the number of uniques in all input values, or 0 if more than MAX_UNIQUES
+    // stops on the first unique past MAX_UNIQUES, which for most data is found early
+    uint8_t val256[256]={0};
+    uint32_t nUniques=0;
+    uint32_t i=0;
+    
+    while (i < nValues)
+    {
+        const uint32_t inVal=inVals[i++];
+        if (val256[inVal] == 0)
+        {
+            if (nUniques == MAX_UNIQUES)
+                return 0;
+            val256[inVal] = 1;
+            sharedOccurrence[inVal] = nUniques;
+            sharedUniques[nUniques++] = (unsigned char)inVal;
+        }
+    }
+    return nUniques;
+} // end countSharedUniques
+
+static uint32_t sharedUniquesBytes(const uint32_t nValues, const uint32_t nSharedUniques)
+{
+    // upper limit of bytes output by td512SharedUniques: blocks that use fewer uniques may do better with td64
+    const uint32_t nBits=nSharedUniques > 1 ? encodingBits[nSharedUniques-1] : 0;
+    uint32_t nBytes=(nValues <= 256 ? 2 : 3) + 2 + nSharedUniques; // info bytes, extension byte, unique count and uniques
+    uint32_t nBytesRemaining=nValues;
+    while (nBytesRemaining >= MIN_VALUES_TO_COMPRESS)
+    {
+        const uint32_t nBlockBytes=nBytesRemaining <= MAX_TD64_BYTES ? nBytesRemaining : MAX_TD64_BYTES;
+        nBytes += 1 + (nBlockBytes * nBits + 7) / 8;
+        nBytesRemaining -= nBlockBytes;
+    }
+    return nBytes + nBytesRemaining;
+} // end sharedUniquesBytes
+
+static uint32_t td64BlocksBytes(const unsigned char *inVals, const uint32_t nValues, const int32_t tableId)
+{
+    // bytes output for 65 to 512 values as td64 blocks with their own uniques, to compare with sharedUniquesBytes
+    uint32_t nBytes=nValues <= 256 ? 2 : 3; // info bytes
+    uint32_t inputOffset=0;
+    
+    while (nValues - inputOffset >= MIN_VALUES_TO_COMPRESS)
+    {
+        const uint32_t nBlockBytes=nValues-inputOffset <= MAX_TD64_BYTES ? nValues-inputOffset : MAX_TD64_BYTES;
+        const int32_t retBits=td64TableSized(inVals+inputOffset, NULL, nBlockBytes, tableId, 1);
+        nBytes += retBits > 0 ? ((uint32_t)retBits+7)/8 : nBlockBytes;
+        inputOffset += nBlockBytes;
+    }
+    return nBytes + nValues - inputOffset;
+} // end td64BlocksBytes
+
+static int32_t td512SharedUniques(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *sharedUniques, const uint32_t *sharedOccurrence, const uint32_t nSharedUniques, const uint32_t extension, const int32_t tableId, const uint32_t sizeOnly)
+{
+    // output the uniques once after the extension byte, then each block of 64 values
+    // as fixed bit indexes into that table, or as td64 when its own uniques are smaller
+    // TD512_EXT_SHARED_UNIQUES_PREVIOUS does not output the table
+    // when sizeOnly is set, blocks are sized with sharedUniquesModeBits and td64_estimate and not output
+    const uint32_t allUniquesUsed=(1u << nSharedUniques) - 1;
+    uint32_t nBytesRemaining=nValues;
+    uint32_t inputOffset=0;
+    uint32_t outputOffset=nValues <= 256 ? 2 : 3;
+    uint32_t passFail=0;
+    uint32_t passFailBit=1;
+    int32_t retBits;
+    
+    outVals[1] = 0;
+    outVals[outputOffset++] = (unsigned char)extension;
+    if (extension == TD512_EXT_SHARED_UNIQUES)
+    {
+        outVals[outputOffset++] = (unsigned char)(nSharedUniques-1);
+        memcpy(outVals+outputOffset, sharedUniques, nSharedUniques);
+        outputOffset += nSharedUniques;
+    }
+    while (nBytesRemaining >= MIN_VALUES_TO_COMPRESS)
+    {
+        const uint32_t nBlockBytes=nBytesRemaining <= MAX_TD64_BYTES ? nBytesRemaining : MAX_TD64_BYTES;
+        uint32_t uniquesUsed;
+        if ((retBits=sizeOnly ? sharedUniquesModeBits(inVals+inputOffset, nBlockBytes, sharedOccurrence, nSharedUniques, &uniquesUsed) :
+             encodeSharedUniquesMode(inVals+inputOffset, outVals+outputOffset, nBlockBytes, sharedOccurrence, nSharedUniques, &uniquesUsed)) < 0)
+            return retBits;
+        if (uniquesUsed != allUniquesUsed)
+        {
+            // fewer uniques in this block: td64 may encode with fewer bits
+            unsigned char tempOutVals[MAX_TD64_BYTES+16];
+            const int32_t retBitstd64=td64TableSized(inVals+inputOffset, tempOutVals, nBlockBytes, tableId, sizeOnly);
+            if (retBitstd64 > 0 && retBitstd64 < retBits)
+            {
+                retBits = retBitstd64;
+                if (!sizeOnly)
+                    memcpy(outVals+outputOffset, tempOutVals, (uint32_t)(retBits+7)/8);
+            }
+        }
+        passFail |= passFailBit;
+        passFailBit <<= 1;
+        outputOffset += (uint32_t)(retBits+7)/8;
+        inputOffset += nBlockBytes;
+        nBytesRemaining -= nBlockBytes;
+    }
+    if (nBytesRemaining > 0)
+    {
+        // final block is < MIN_VALUES_TO_COMPRESS: pass/fail bit is 0
+        memcpy(outVals+outputOffset, inVals+inputOffset, nBytesRemaining);
+        outputOffset += nBytesRemaining;
+    }
+    td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, passFail);
+    return (int32_t)outputOffset;
+} // end td512SharedUniques
+
+static int32_t td512Encode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxOutBytes, const int32_t tableId, const uint32_t sizeOnly)
 {
     // set initial bits according to number of values
     //  0 1 to 64 values plus 1 pass/fail
     // 01 65 to 320 values plus 5 pass/fail (requires a second byte)
     // 11 321 to 512 values plus 8 pass/fail (may require a third byte)
+    // stops with -151 when the values already encoded fill maxOutBytes
+    // text mode uses registered table tableId, or the predefined tables when tableId is -1
+    // when sizeOnly is set, td64 blocks are sized with td64_estimate, and text, string and shared uniques modes count their bits without output
     // returns number of bytes output
     int32_t retBits;
     int32_t retBytes;
@@ -166,7 +341,7 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
             memcpy(outVals+1, inVals, nValues);
             return (int32_t)nValues + 1;
         }
-        if ((retBits=td64(inVals, outVals+1, nValues)) < 0)
+        if ((retBits=td64TableSized(inVals, outVals+1, nValues, tableId, sizeOnly)) < 0)
             return retBits; // error occurred
         if (retBits == 0)
         {
@@ -194,7 +369,16 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
     uint32_t bytesProcessed;
     uint32_t nBlockBytes;
     uint32_t td64on=0;
-    uint32_t extendedMode=0; // 0=td64  1,2=extended mode
+    uint32_t extendedMode=0; // 0=td64  1,2=extended mode  3=extension
+    unsigned char sharedUniques[MAX_UNIQUES];
+    uint32_t sharedOccurrence[256];
+    uint32_t nSharedUniques=0;
+    if (nValues < MIN_VALUES_EXTENDED_MODE && (nSharedUniques=countSharedUniques(inVals, nValues, sharedUniques, sharedOccurrence))
+        && sharedUniquesBytes(nValues, nSharedUniques) < td64BlocksBytes(inVals, nValues, tableId))
+    {
+        // all td64 blocks can use one unique table, which does better than the uniques of each block
+        return td512SharedUniques(inVals, outVals, nValues, sharedUniques, sharedOccurrence, nSharedUniques, TD512_EXT_SHARED_UNIQUES, tableId, sizeOnly);
+    }
     outVals[1] = 0;
     if (nValues <= 256)
     {
@@ -210,10 +394,12 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
     while (nBytesRemaining >= MIN_VALUES_TO_COMPRESS)
     {
         //uint32_t infoByte=0;
+        if ((uint32_t)retBytes >= maxOutBytes)
+            return -151; // output of the remaining values does not fit in maxOutBytes
         if (nBytesRemaining < MIN_VALUES_EXTENDED_MODE || td64on)
         {
             nBlockBytes = nBytesRemaining <=MAX_TD64_BYTES ? nBytesRemaining : MAX_TD64_BYTES;
-            if ((retBits=td64(inVals+inputOffset, outVals+outputOffset, nBlockBytes)) < 0)
+            if ((retBits=td64TableSized(inVals+inputOffset, outVals+outputOffset, nBlockBytes, tableId, sizeOnly)) < 0)
                 return retBits; // error occurred
             if (retBits == 0)
             {
@@ -243,7 +429,7 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
             // -------check if all input values can be handled together--------
             uint32_t highBitCheck;
             uint32_t checkTMret;
-            if ((checkTMret=checkTextMode(inVals, nBytesRemaining, &highBitCheck)) == 1)
+            if ((checkTMret=checkTextMode(inVals, nBytesRemaining, &highBitCheck, tableId)) == 1)
             {
                 // process in extended text mode
                 unsigned char val256[256];
@@ -251,9 +437,14 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
                 gExtendedTextCnt++;
 #endif
                 extendedMode = 1; // text compression mode called directly
-                retBits = encodeAdaptiveTextMode(inVals+inputOffset, outVals+outputOffset, nBytesRemaining, val256, 1, highBitCheck, nBytesRemaining-16);
+                // text mode stops at an escaped value past maxBytes: the smaller of 16 bytes of compression and maxOutBytes
+                const uint32_t maxTextBytes=nBytesRemaining-16 < maxOutBytes-outputOffset ? nBytesRemaining-16 : maxOutBytes-outputOffset;
+                retBits = sizeOnly ? adaptiveTextModeBits(inVals+inputOffset, outVals+outputOffset, nBytesRemaining, val256, 1, highBitCheck, maxTextBytes, tableId) :
+                    encodeAdaptiveTextMode(inVals+inputOffset, outVals+outputOffset, nBytesRemaining, val256, 1, highBitCheck, maxTextBytes, tableId);
                 if (retBits < 0)
                     return retBits;
+                if (outputOffset + (uint32_t)(retBits+7)/8 > maxOutBytes || (retBits == 0 && maxTextBytes < nBytesRemaining-16))
+                    return -151; // text mode output does not fit in maxOutBytes
                 if (retBits == 0)
                 {
                     // too many non-predefined chars to compress
@@ -281,12 +472,18 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
             } // end text mode processing
             
             unsigned char tempOutVals[MAX_TD64_BYTES];
-            if (checkTMret == 0 && (retBits=checktd64(inVals, tempOutVals)))
+            td64Analysis analysis;
+            if (checkTMret == 0 && (retBits=checktd64(inVals, tempOutVals, &analysis, tableId)))
             {
                 // determine data best handled by td64
 #ifdef TD512_TEST_MODE
                 gtd64Cnt++;
 #endif
+                if (retBits == 1 && (nSharedUniques=countSharedUniques(inVals, nValues, sharedUniques, sharedOccurrence)))
+                {
+                    // all td64 blocks can use one unique table
+                    return td512SharedUniques(inVals, outVals, nValues, sharedUniques, sharedOccurrence, nSharedUniques, TD512_EXT_SHARED_UNIQUES, tableId, sizeOnly);
+                }
                 if (retBits == 2)
                 {
                     // assume random data and fail first 64 bytes
@@ -300,7 +497,31 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
                     td64on = 1;
                     continue;
                 }
-                if (retBits > 1)
+                if (retBits == 1)
+                {
+                    // first block uses the analysis from checktd64 rather than td64 repeating it
+                    if ((retBits=td64Analyzed(inVals, outVals+outputOffset, MAX_TD64_BYTES, &analysis)) < 0)
+                        return retBits; // error occurred
+                    if (retBits == 0)
+                    {
+                        // failure leaves pass/fail bit 0
+                        memcpy(outVals+outputOffset, inVals, MAX_TD64_BYTES);
+                        bytesProcessed = MAX_TD64_BYTES;
+                    }
+                    else
+                    {
+                        passFail |= passFailBit;
+                        bytesProcessed = (uint32_t)retBits / 8;
+                        if (retBits & 7)
+                            bytesProcessed++;
+                    }
+                    retBytes += bytesProcessed;
+                    nBytesRemaining -= MAX_TD64_BYTES;
+                    passFailBit <<= 1;
+                    inputOffset += MAX_TD64_BYTES;
+                    outputOffset += bytesProcessed;
+                }
+                else if (retBits > 1)
                 {
                     // use the values from checktd64
                     passFail |= passFailBit;
@@ -323,13 +544,21 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
             gExtendedStringCnt++;
 #endif
             extendedMode = 2; // extended string mode called directly
+            nSharedUniques = countSharedUniques(inVals, nValues, sharedUniques, sharedOccurrence);
             // add 1 byte for number values read as extended string mode stops after 64 uniques encountered
             outputOffset++;
             retBytes++;
-            retBits = encodeExtendedStringMode(inVals+inputOffset, outVals+outputOffset, nValues, &nValuesRead);
+            retBits = encodeExtendedStringModeMax(inVals+inputOffset, outVals+outputOffset, nValues, &nValuesRead, maxOutBytes-outputOffset, sizeOnly);
             assert(nValues>=nValuesRead);
+            if (retBits < 0 && retBits != -102)
+                return retBits; // -102: string mode output does not fit in maxOutBytes
+            if (nSharedUniques && (retBits <= 0 || outputOffset + (uint32_t)(retBits+7)/8 > sharedUniquesBytes(nValues, nSharedUniques)))
+            {
+                // few enough uniques that a shared unique table does better than string mode
+                return td512SharedUniques(inVals, outVals, nValues, sharedUniques, sharedOccurrence, nSharedUniques, TD512_EXT_SHARED_UNIQUES, tableId, sizeOnly);
+            }
             if (retBits < 0)
-                return retBits;
+                return -151;
             if (retBits == 0)
             {
                 // no compression
@@ -370,159 +599,1578 @@ int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_
         retBytes += nBytesRemaining;
     }
     // --------------- END OF COMPRESSION ---------------
-    // process info bytes
-    if (nValues <= 320)
-    {
-        // nValues 65 to 320, excess 65 value
-        outVals[0] = (unsigned char)((nValues-65) << 2) | 1; // indicator of 65 to 320 values, and lower 6 bits of 8-bit excess 65 value
-        outVals[1] |= (unsigned char)((nValues-65)>>6) & 3; // upper 2 bits of value
-    }
-    else
-    {
-        // nValues 321 to 512, excess 321 value
-        outVals[0] = (unsigned char)((nValues-321) << 2) | 3; // indicator of 321 to 512 values, and lower 6 bits of 8-bit excess 321 value
-        outVals[1] |= (unsigned char)((nValues-321)>>6) & 3; // upper 2 bits of value; string mode uses third bit for 9th bit of string count; for <=256 values, upper four bits are pass/fail
-    }
-    // two bits indicates how compression starts; extended modes for >= 128 values continue with td64 for any remaining values
-    // 0 td64
-    // 1 extended text mode
-    // 2 extended string mode
-    outVals[1] |= extendedMode << 2; // used for >= 128 values
-    if (nValues <= 256)
-    {
-        outVals[1] |= passFail << 4; // use upper four bits of second info byte
-    }
-    else
+    td512OutputInfoBytes(outVals, nValues, extendedMode, passFail);
+    return retBytes;
+} // end td512Encode
+
+static uint32_t countRepeatedValues(const unsigned char *inVals, const uint32_t nValues, uint32_t *highBitCheck)
+{
+    // number of values equal to the previous value
+    // highBitCheck is the OR of all values, so that checkUtf8Text is skipped for values without the high bit set
+    uint32_t nRepeated=0;
+    uint32_t highBits=inVals[0];
+    uint32_t i;
+    for (i=1; i<nValues; i++)
     {
-        outVals[2] = passFail; // use third info byte
+        nRepeated += inVals[i] == inVals[i-1];
+        highBits |= inVals[i];
     }
-    return retBytes;
-} // end td512
+    *highBitCheck = highBits;
+    return nRepeated;
+} // end countRepeatedValues
 
-int32_t td512d(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed)
+static inline uint32_t outputRunLengthLiterals(const unsigned char *inVals, unsigned char *outVals, uint32_t outputOffset, uint32_t literalStart, const uint32_t literalEnd, const uint32_t sizeOnly)
 {
-    // decompress td512 compressed data
-    // first bit or two indicate number of values from 1 to 512
-    //  0 1 to 64 values plus 1 pass/fail bit
-    // 01 65 to 320 values: excess 65 value, second byte holds upper two bits value
-    // 11 321 to 512 values: excess 321 second byte holds upper two bits value
-    // for 65 to 512 values: all modes bits in second byte and pass/fail in third byte
-    // return number of bytes output
-    int32_t retBytes=0;
-    uint32_t nValues;
-    uint32_t bytesProcessed;
-    uint32_t passFail;
-    uint32_t firstByte=inVals[0];
-    
-    if ((firstByte & 1) == 0)
+    // output literals in tokens of up to TD512_MAX_RUN_LITERALS values, or when sizeOnly is set only count them
+    while (literalStart < literalEnd)
     {
-        // decompress 1 to 64 values
-        nValues = ((firstByte >> 1) & 0x3f) + 1;
-        if (firstByte & 128)
+        const uint32_t nLiterals=literalEnd-literalStart < TD512_MAX_RUN_LITERALS ? literalEnd-literalStart : TD512_MAX_RUN_LITERALS;
+        if (!sizeOnly)
         {
-            retBytes = td64d(inVals+1, outVals, nValues, &bytesProcessed);
-            *totalBytesProcessed = bytesProcessed + 1;
-            return retBytes;
+            outVals[outputOffset] = (unsigned char)(nLiterals-1);
+            memcpy(outVals+outputOffset+1, inVals+literalStart, nLiterals);
         }
-        // uncompressed
-        memcpy(outVals, inVals+1, nValues);
-        *totalBytesProcessed = nValues + 1;
-        return (int32_t)nValues;
+        outputOffset += 1 + nLiterals;
+        literalStart += nLiterals;
     }
+    return outputOffset;
+} // end outputRunLengthLiterals
+
+static int32_t td512RunLength(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxBytes, const uint32_t sizeOnly)
+{
+    // output the info bytes and extension byte for 65 to 512 values followed by tokens
+    // 1lllllll value: run of l+TD512_MIN_RUN_LENGTH of value
+    // 0lllllll values: l+1 literal values
+    // returns -151 once the tokens output do not fit in maxBytes; outVals has room for the tokens of 512 values
+    // when sizeOnly is set, the tokens are counted without output
+    uint32_t outputOffset=nValues <= 256 ? 2 : 3;
+    uint32_t literalStart=0;
+    uint32_t i=0;
     
-    uint32_t secondByte=inVals[1];
-    uint32_t thirdByte=inVals[2];
-    uint32_t inputOffset=2; // point past first two info bytes for <= 256 values
-    uint32_t outputOffset=0;
-    uint32_t nBytesRemaining;
-    int32_t blockRetBytes;
-    // decompress 65 to 512 values
-    if ((firstByte & 3) == 1)
-    {
-        // 65 to 320 values
-        nValues = ((firstByte >> 2) | (secondByte & 3) << 6) + 65;
-    }
-    else
-    {
-        // 321 to 512 values
-        nValues = ((firstByte >> 2) | (secondByte & 3) << 6) + 321;
-    }
-    nBytesRemaining = nValues;
-    if (nValues <= 256)
+    outVals[1] = 0;
+    outVals[outputOffset++] = TD512_EXT_RUN_LENGTH;
+    while (i < nValues)
     {
-        passFail = secondByte >> 4;
+        const unsigned char runVal=inVals[i];
+        uint32_t runEnd=i+1;
+        while (runEnd < nValues && inVals[runEnd] == runVal && runEnd-i < TD512_MAX_RUN_LENGTH)
+            runEnd++;
+        if (runEnd-i >= TD512_MIN_RUN_LENGTH)
+        {
+            outputOffset = outputRunLengthLiterals(inVals, outVals, outputOffset, literalStart, i, sizeOnly);
+            if (!sizeOnly)
+            {
+                outVals[outputOffset] = (unsigned char)(0x80 | (runEnd-i-TD512_MIN_RUN_LENGTH));
+                outVals[outputOffset+1] = runVal;
+            }
+            outputOffset += 2;
+            literalStart = runEnd;
+            if (outputOffset > maxBytes)
+                return -151;
+        }
+        i = runEnd;
     }
-    else
+    outputOffset = outputRunLengthLiterals(inVals, outVals, outputOffset, literalStart, nValues, sizeOnly);
+    if (outputOffset > maxBytes)
+        return -151;
+    td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, 1);
+    return (int32_t)outputOffset;
+} // end td512RunLength
+
+static inline uint32_t utf8SequenceLength(const uint32_t leadVal)
+{
+    // bytes in a UTF-8 sequence starting with leadVal, 0 for values that cannot start a multibyte sequence
+    if (leadVal >= 0xc2 && leadVal <= 0xdf)
+        return 2;
+    if (leadVal >= 0xe0 && leadVal <= 0xef)
+        return 3;
+    if (leadVal >= 0xf0 && leadVal <= 0xf4)
+        return 4;
+    return 0;
+} // end utf8SequenceLength
+
+static inline uint32_t utf8ContinuationBytes(const unsigned char *inVals, const uint32_t nValues, const uint32_t seqLength)
+{
+    // 1 when the seqLength-1 values after the lead byte are continuation bytes
+    uint32_t i;
+    if (seqLength == 0 || seqLength > nValues)
+        return 0;
+    for (i=1; i<seqLength; i++)
     {
-        // pass fail in third byte for > 256 values
-        passFail = thirdByte;
-        inputOffset++;
+        if ((inVals[i] & 0xc0) != 0x80)
+            return 0;
     }
-    const uint32_t extendedMode = (secondByte >> 2) & 3;
-    assert(extendedMode <= 2);
-    if (passFail == 0)
+    return 1;
+} // end utf8ContinuationBytes
+
+static uint32_t checkUtf8Text(const unsigned char *inVals, const uint32_t nValues)
+{
+    // 1 when the values have at least MIN_UTF8_SEQUENCES multibyte sequences and no other values with the high bit set,
+    // except for partial sequences at the start and end
+    uint32_t nSequences=0;
+    uint32_t i=0;
+    while (i < nValues && (inVals[i] & 0xc0) == 0x80)
+        i++; // continuation of a sequence in the previous block
+    while (i < nValues)
     {
-        // all tests failed, copy all original values to output
-        if (extendedMode == 2)
-            inputOffset++;
-        memcpy(outVals, inVals+inputOffset, nValues);
-        *totalBytesProcessed = inputOffset + nValues;
-        return (int32_t)nValues;
+        const uint32_t inVal=inVals[i];
+        if (inVal < 0x80)
+        {
+            i++;
+            continue;
+        }
+        const uint32_t seqLength=utf8SequenceLength(inVal);
+        if (utf8ContinuationBytes(inVals+i, nValues-i, seqLength))
+        {
+            nSequences++;
+            i += seqLength;
+        }
+        else if (seqLength && i+seqLength > nValues)
+            break; // sequence continues in the next block
+        else
+            return 0;
     }
-    if (nValues >= MIN_VALUES_EXTENDED_MODE)
+    return nSequences >= MIN_UTF8_SEQUENCES;
+} // end checkUtf8Text
+
+static uint32_t utf8PageTransform(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // output a multibyte sequence without its lead byte when the lead byte is the same as that of the previous sequence
+    // values that are not part of a sequence are escaped with TD512_UTF8_ESCAPE
+    // returns the number of values output, or 0 if not fewer than nValues
+    uint32_t pageLead=0;
+    uint32_t outputOffset=0;
+    uint32_t i=0;
+    while (i < nValues)
     {
-        if (extendedMode == 1)
+        const uint32_t inVal=inVals[i];
+        if (outputOffset + 4 > nValues)
+            return 0;
+        if (inVal < 0x80)
         {
-            // process text mode
-            if (passFail & 1)
-            {
-                // decompress
-                blockRetBytes = decodeAdaptiveTextMode(inVals+inputOffset, outVals, nValues, &bytesProcessed);
-                nBytesRemaining = 0;
-            }
-            else
-            {
-                // no compression for this call: first 128 values are originals
-                memcpy(outVals, inVals+inputOffset, 128); //
-                bytesProcessed = 128;
-                blockRetBytes = 128;
-                nBytesRemaining = nValues - 128; // continue with td64
-            }
-            passFail >>= 1;
-            inputOffset += bytesProcessed;
-            outputOffset += blockRetBytes;
-            retBytes = blockRetBytes;
-        } // end process text mode
-        else if (extendedMode == 2)
+            outVals[outputOffset++] = (unsigned char)inVal;
+            i++;
+            continue;
+        }
+        const uint32_t seqLength=utf8SequenceLength(inVal);
+        if (utf8ContinuationBytes(inVals+i, nValues-i, seqLength))
         {
-            // process string mode
-            uint32_t nValuesThisCall=inVals[inputOffset++]; // lower 8 bits of values read in first byte
-            if (nValues <= 256)
-                nValuesThisCall++; // 8-bit value
-            else
-            {
-                nValuesThisCall |= (inVals[1]&0x10) << 4; // 9th bit
-                nValuesThisCall++; // 9-bit value
-            }
-            if (passFail & 1)
+            if (inVal == pageLead)
             {
-                blockRetBytes=decodeExtendedStringMode(inVals+inputOffset, outVals+outputOffset, nValuesThisCall, &bytesProcessed);
-                if (blockRetBytes < 0)
-                    return blockRetBytes; // error return
+                // same page: continuation bytes only
+                memcpy(outVals+outputOffset, inVals+i+1, seqLength-1);
+                outputOffset += seqLength-1;
             }
             else
             {
-                // no compression for this block
-                memcpy(outVals, inVals+inputOffset, nValuesThisCall);
-                bytesProcessed = nValuesThisCall;
-                blockRetBytes = nValuesThisCall;
+                memcpy(outVals+outputOffset, inVals+i, seqLength);
+                outputOffset += seqLength;
+                pageLead = inVal;
             }
-            inputOffset += bytesProcessed;
-            outputOffset += nValuesThisCall;
-            passFail >>= 1;
-            retBytes = blockRetBytes;
-            nBytesRemaining -= blockRetBytes; // continue with td64
-        } // end process string mode
+            i += seqLength;
+        }
+        else
+        {
+            outVals[outputOffset++] = TD512_UTF8_ESCAPE;
+            outVals[outputOffset++] = (unsigned char)inVal;
+            i++;
+        }
+    }
+    return outputOffset < nValues ? outputOffset : 0;
+} // end utf8PageTransform
+
+static int32_t td512Utf8Text(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxBytes, const int32_t tableId, const uint32_t sizeOnly)
+{
+    // output the info bytes and extension byte for 65 to 512 values followed by td512 of the page transform
+    // returns 0 when the page transform does not remove at least 1/16 of the values, or -151 if the output does not fit in maxBytes
+    // when sizeOnly is set, the page transform is sized by td512Encode without output
+    unsigned char pageVals[512];
+    uint32_t outputOffset=nValues <= 256 ? 2 : 3;
+    int32_t retBytes;
+    
+    const uint32_t nPageVals=utf8PageTransform(inVals, pageVals, nValues);
+    if (nPageVals == 0 || nPageVals > nValues - nValues/16)
+        return 0;
+    if (outputOffset + 1 >= maxBytes)
+        return -151;
+    outVals[1] = 0;
+    outVals[outputOffset++] = TD512_EXT_UTF8;
+    if ((retBytes=td512Encode(pageVals, outVals+outputOffset, nPageVals, maxBytes-outputOffset, tableId, sizeOnly)) <= 0)
+        return retBytes;
+    td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, 1);
+    return (int32_t)outputOffset + retBytes;
+} // end td512Utf8Text
+
+static int32_t td512NumericText(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxBytes, const uint32_t sizeOnly)
+{
+    // output the info bytes and extension byte for 65 to 512 values followed by numeric text mode
+    // returns 0 when numeric text mode does not compress, or -151 if the output does not fit in maxBytes
+    // when sizeOnly is set, numeric text mode is sized with numericTextModeBits without output
+    uint32_t outputOffset=nValues <= 256 ? 2 : 3;
+    int32_t retBits;
+    
+    if (outputOffset + 1 >= maxBytes)
+        return -151;
+    outVals[1] = 0;
+    outVals[outputOffset++] = TD512_EXT_NUMERIC_TEXT;
+    // numeric text mode sizes its output before encoding it: fewer than (maxBytes-outputOffset)*8+1 bits fit in maxBytes
+    const uint32_t boundedByMax=maxBytes < nValues;
+    const uint32_t maxBits=boundedByMax ? (maxBytes-outputOffset)*8+1 : nValues*8-outputOffset*8;
+    if ((retBits=sizeOnly ? numericTextModeBits(inVals, nValues, maxBits) : encodeNumericTextMode(inVals, outVals+outputOffset, nValues, maxBits)) < 0)
+        return retBits;
+    if (retBits == 0)
+        return boundedByMax ? -151 : 0;
+    td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, 1);
+    return (int32_t)outputOffset + (retBits+7)/8;
+} // end td512NumericText
+
+static int32_t td512AlphabetMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t flags, const uint32_t maxBytes, const uint32_t sizeOnly)
+{
+    // output the info bytes and extension byte for 65 to 512 values followed by hex or base64 alphabet mode
+    // returns -151 without encoding when the output does not fit in maxBytes
+    // when sizeOnly is set, returns the bytes without encoding
+    uint32_t outputOffset=nValues <= 256 ? 2 : 3;
+    int32_t retBits=alphabetModeBits(inVals, nValues, flags);
+    
+    if (outputOffset + 1 + (uint32_t)(retBits+7)/8 > maxBytes)
+        return -151;
+    outVals[1] = 0;
+    outVals[outputOffset++] = TD512_EXT_ALPHABET;
+    if (!sizeOnly)
+        retBits = encodeAlphabetMode(inVals, outVals+outputOffset, nValues, flags);
+    td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, 1);
+    return (int32_t)outputOffset + (retBits+7)/8;
+} // end td512AlphabetMode
+
+static int32_t td512Bounded(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxOutBytes, const int32_t tableId, const uint32_t sizeOnly)
+{
+    // for 65 to 512 values with half or more equal to the previous value, run-length coding is output
+    // when it is at most 1/8 of the values or smaller than td512Encode
+    // for 65 to 512 hex values, alphabet mode is output, and for base64 values, when smaller than td512Encode
+    // for 65 to 512 values starting with digits and separators, numeric text mode is output when smaller than td512Encode
+    // for 65 to 512 values of UTF-8 text, td512 of the page transform is output when smaller than td512Encode
+    unsigned char extOutVals[512+16];
+    int32_t retBytes;
+    int32_t extBytes;
+    uint32_t alphabetFlags;
+    uint32_t highBitCheck;
+    
+    if (nValues <= MAX_TD64_BYTES || nValues > 512)
+        return td512Encode(inVals, outVals, nValues, maxOutBytes, tableId, sizeOnly);
+    if (countRepeatedValues(inVals, nValues, &highBitCheck) >= nValues / 2)
+    {
+        extBytes = td512RunLength(inVals, extOutVals, nValues, maxOutBytes, sizeOnly);
+        if ((uint32_t)extBytes <= nValues / 8)
+        {
+            if (!sizeOnly)
+                memcpy(outVals, extOutVals, (uint32_t)extBytes);
+            return extBytes;
+        }
+    }
+    else if ((alphabetFlags=checkAlphabetMode(inVals, nValues)) != 0)
+    {
+        if (alphabetFlags & 3)
+            return td512AlphabetMode(inVals, outVals, nValues, alphabetFlags, maxOutBytes, sizeOnly); // 4-bit hex is not improved by other modes
+        extBytes = td512AlphabetMode(inVals, extOutVals, nValues, alphabetFlags, maxOutBytes, sizeOnly);
+    }
+    else if (countNumericTextChars(inVals, MAX_TD64_BYTES) >= MIN_NUMERIC_TEXT_CHARS)
+        extBytes = td512NumericText(inVals, extOutVals, nValues, maxOutBytes, sizeOnly);
+    else if ((highBitCheck & 0x80) && checkUtf8Text(inVals, nValues))
+    {
+        extBytes = td512Utf8Text(inVals, extOutVals, nValues, maxOutBytes, tableId, sizeOnly);
+        if (extBytes > 0 && (uint32_t)extBytes <= nValues - nValues/4)
+        {
+            // 25% compression is more than td512Encode gets for UTF-8 text
+            if (!sizeOnly)
+                memcpy(outVals, extOutVals, (uint32_t)extBytes);
+            return extBytes;
+        }
+    }
+    else
+        return td512Encode(inVals, outVals, nValues, maxOutBytes, tableId, sizeOnly);
+    retBytes = td512Encode(inVals, outVals, nValues, maxOutBytes, tableId, sizeOnly);
+    if ((retBytes < 0 && retBytes != -151) || extBytes <= 0 || (retBytes > 0 && retBytes <= extBytes))
+        return retBytes;
+    if (!sizeOnly)
+        memcpy(outVals, extOutVals, (uint32_t)extBytes);
+    return extBytes;
+} // end td512Bounded
+
+int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // td512Encode never stops at TD512_MAX_OUTPUT_BYTES
+    return td512Bounded(inVals, outVals, nValues, TD512_MAX_OUTPUT_BYTES, -1, 0);
+} // end td512
+
+int32_t td512_table(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId)
+{
+    // td512 with text mode encoding with the table registered as tableId by td64RegisterTextTable,
+    // or with the predefined tables when tableId is -1
+    // decoded by td512d when the same table is registered
+    int32_t retVal;
+    if ((retVal=td64CheckTextTable(tableId)) < 0)
+        return retVal;
+    return td512Bounded(inVals, outVals, nValues, TD512_MAX_OUTPUT_BYTES, tableId, 0);
+} // end td512_table
+
+int32_t td512_max(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxOutBytes)
+{
+    // td512 when its output fits in maxOutBytes, such as a fixed-size slot smaller than nValues
+    // outVals is written only when the output fits, and encoding stops once the values encoded fill maxOutBytes
+    // returns the number of bytes output, or -151 if the output does not fit
+    // td512 may write more bytes than the number of values, so the output is always encoded into tempOutVals
+    unsigned char tempOutVals[TD512_MAX_OUTPUT_BYTES];
+    int32_t retBytes;
+    
+    if ((retBytes=td512Bounded(inVals, tempOutVals, nValues, maxOutBytes, -1, 0)) < 0)
+        return retBytes;
+    if ((uint32_t)retBytes > maxOutBytes)
+        return -151; // output does not fit in maxOutBytes
+    memcpy(outVals, tempOutVals, (uint32_t)retBytes);
+    return retBytes;
+} // end td512_max
+
+int32_t td512_estimate(const unsigned char *inVals, const uint32_t nValues)
+{
+    // number of bytes td512 outputs for nValues values, with the modes selected by the same code as td512
+    // td64 blocks are sized with td64_estimate, and the extended modes and extensions count their bits without output
+    // tempOutVals gets only the info bytes and uniques that the modes write while sizing
+    // returns the number of bytes td512 outputs
+    unsigned char tempOutVals[TD512_MAX_OUTPUT_BYTES];
+    
+    return td512Bounded(inVals, tempOutVals, nValues, TD512_MAX_OUTPUT_BYTES, -1, 1);
+} // end td512_estimate
+
+void td512InitCtx(td512ctx *ctx)
+{
+    // no dictionary: td512_ctx and td512d_ctx are the same as td512 and td512d
+    ctx->nPrimeVals = 0;
+    ctx->nPrimeUniques = 0;
+    ctx->nStreamWindowVals = 0;
+    ctx->streamMode = 0;
+    ctx->prevMode = TD512_STREAM_NONE;
+    ctx->nStreamBlocks = 0;
+    ctx->nPrevSharedUniques = 0;
+} // end td512InitCtx
+
+void td512InitStreamCtx(td512ctx *ctx)
+{
+    // consecutive blocks of a stream: the mode of each block is carried to the next
+    // the decoder must be initialized the same way and decode blocks in order
+    td512InitCtx(ctx);
+    ctx->streamMode = 1;
+} // end td512InitStreamCtx
+
+int32_t td512SetStreamWindow(td512ctx *ctx, const uint32_t nWindowVals)
+{
+    // strings in extended string mode may refer to the last nWindowVals values of the stream
+    // a dictionary that is loaded is the start of the window
+    if (ctx->streamMode == 0)
+        return -132; // requires td512InitStreamCtx
+    if (nWindowVals > TD512_MAX_STREAM_WINDOW)
+        return -133;
+    ctx->nStreamWindowVals = nWindowVals;
+    return (int32_t)nWindowVals;
+} // end td512SetStreamWindow
+
+static uint32_t getPrimeUniques(const unsigned char *primeVals, const uint32_t nPrimeVals, unsigned char *primeUniques)
+{
+    // return the uniques of the prime values in order of first occurrence
+    // uniques beyond MAX_UNIQUES_EXTENDED_STRING_MODE are not included
+    uint8_t val256[256]={0};
+    uint32_t nPrimeUniques=0;
+    uint32_t i;
+    
+    for (i=0; i<nPrimeVals && nPrimeUniques < MAX_UNIQUES_EXTENDED_STRING_MODE; i++)
+    {
+        const uint32_t primeVal=primeVals[i];
+        if (val256[primeVal] == 0)
+        {
+            val256[primeVal] = 1;
+            primeUniques[nPrimeUniques++] = (unsigned char)primeVal;
+        }
+    }
+    return nPrimeUniques;
+} // end getPrimeUniques
+
+int32_t td512LoadDictionary(td512ctx *ctx, const unsigned char *dictVals, const uint32_t nDictVals)
+{
+    // load dictionary values into ctx, such as from td512TrainDictionary
+    // the same dictionary must be loaded to decode
+    if (nDictVals == 0 || nDictVals > TD512_MAX_DICTIONARY_VALUES)
+        return -133;
+    memcpy(ctx->primeVals, dictVals, nDictVals);
+    ctx->nPrimeVals = nDictVals;
+    ctx->nPrimeUniques = getPrimeUniques(ctx->primeVals, ctx->nPrimeVals, ctx->primeUniques);
+    return (int32_t)nDictVals;
+} // end td512LoadDictionary
+
+static void td512UpdateWindow(td512ctx *ctx, const unsigned char *vals, const uint32_t nValues)
+{
+    // append the values of a stream block to the window, dropping the oldest values
+    const uint32_t nWindowVals=ctx->nStreamWindowVals;
+    uint32_t nKeepVals=ctx->nPrimeVals;
+    
+    if (nWindowVals == 0)
+        return;
+    if (nValues >= nWindowVals)
+    {
+        memcpy(ctx->primeVals, vals+nValues-nWindowVals, nWindowVals);
+        ctx->nPrimeVals = nWindowVals;
+    }
+    else
+    {
+        if (nKeepVals+nValues > nWindowVals)
+        {
+            nKeepVals = nWindowVals - nValues;
+            memmove(ctx->primeVals, ctx->primeVals+ctx->nPrimeVals-nKeepVals, nKeepVals);
+        }
+        memcpy(ctx->primeVals+nKeepVals, vals, nValues);
+        ctx->nPrimeVals = nKeepVals + nValues;
+    }
+    ctx->nPrimeUniques = getPrimeUniques(ctx->primeVals, ctx->nPrimeVals, ctx->primeUniques);
+} // end td512UpdateWindow
+
+static int32_t td512td64Blocks(const unsigned char *inVals, unsigned char *outVals, uint32_t nBytesRemaining, uint32_t outputOffset, const uint32_t maxOutBytes, uint32_t *passFail, uint32_t passFailBit)
+{
+    // encode values remaining after an extended mode in blocks of 64 with td64
+    // td64 may write 2 bytes per value before it fails, so no block is started without that room in maxOutBytes
+    // returns the output offset past the last block, or -151 if outVals does not have room
+    uint32_t inputOffset=0;
+    int32_t retBits;
+    while (nBytesRemaining >= MIN_VALUES_TO_COMPRESS)
+    {
+        const uint32_t nBlockBytes=nBytesRemaining <= MAX_TD64_BYTES ? nBytesRemaining : MAX_TD64_BYTES;
+        if (outputOffset + nBlockBytes*2 > maxOutBytes)
+            return -151; // block may be written past maxOutBytes
+        if ((retBits=td64(inVals+inputOffset, outVals+outputOffset, nBlockBytes)) < 0)
+            return retBits; // error occurred
+        if (retBits == 0)
+        {
+            // failure leaves pass/fail bit 0
+            memcpy(outVals+outputOffset, inVals+inputOffset, nBlockBytes);
+            outputOffset += nBlockBytes;
+        }
+        else
+        {
+            *passFail |= passFailBit;
+            outputOffset += (uint32_t)(retBits+7)/8;
+        }
+        passFailBit <<= 1;
+        inputOffset += nBlockBytes;
+        nBytesRemaining -= nBlockBytes;
+    }
+    if (nBytesRemaining > 0)
+    {
+        // final block is < MIN_VALUES_TO_COMPRESS: pass/fail bit is 0
+        if (outputOffset + nBytesRemaining > maxOutBytes)
+            return -151;
+        memcpy(outVals+outputOffset, inVals+inputOffset, nBytesRemaining);
+        outputOffset += nBytesRemaining;
+    }
+    return (int32_t)outputOffset;
+} // end td512td64Blocks
+
+static inline void transposeValues(const unsigned char *inVals, unsigned char *outVals, const uint32_t nElements, const uint32_t elementWidth)
+{
+    // byte i of each element is output to plane i
+    uint32_t i, j;
+    for (i=0; i<elementWidth; i++)
+    {
+        unsigned char *plane=outVals+i*nElements;
+        for (j=0; j<nElements; j++)
+            plane[j] = inVals[j*elementWidth+i];
+    }
+} // end transposeValues
+
+static inline void untransposeValues(const unsigned char *inVals, unsigned char *outVals, const uint32_t nElements, const uint32_t elementWidth)
+{
+    // plane i is output to byte i of each element
+    uint32_t i, j;
+    for (j=0; j<nElements; j++)
+    {
+        for (i=0; i<elementWidth; i++)
+            outVals[j*elementWidth+i] = inVals[i*nElements+j];
+    }
+} // end untransposeValues
+
+static void transposeByWidth(const unsigned char *inVals, unsigned char *outVals, const uint32_t nElements, const uint32_t elementWidth, const uint32_t inverse)
+{
+    // constant widths let the compiler unroll and vectorize the loops
+    switch (elementWidth)
+    {
+        case 2:
+            inverse ? untransposeValues(inVals, outVals, nElements, 2) : transposeValues(inVals, outVals, nElements, 2);
+            break;
+        case 4:
+            inverse ? untransposeValues(inVals, outVals, nElements, 4) : transposeValues(inVals, outVals, nElements, 4);
+            break;
+        case 8:
+            inverse ? untransposeValues(inVals, outVals, nElements, 8) : transposeValues(inVals, outVals, nElements, 8);
+            break;
+        default:
+            inverse ? untransposeValues(inVals, outVals, nElements, elementWidth) : transposeValues(inVals, outVals, nElements, elementWidth);
+            break;
+    }
+} // end transposeByWidth
+
+int32_t td512_transpose(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t elementWidth)
+{
+    // for arrays of elements of elementWidth bytes, encode byte planes in blocks of 64 with td64
+    // the planes of nearly constant high-order bytes compress separately from the low-order bytes
+    // values past the last whole element follow the planes
+    // uses td512 when there are fewer than 65 values or the planes do not compress
+    unsigned char planeVals[512+1]; // td64 string mode reads one value past its input
+    uint32_t outputOffset=nValues <= 256 ? 2 : 3;
+    uint32_t passFail=0;
+    int32_t retBytes;
+    
+    if ((nValues == 0) || (nValues > 512))
+        return -128; // number of input values not supported
+    if (elementWidth < 2 || elementWidth > TD512_MAX_TRANSPOSE_WIDTH)
+        return -137;
+    if (nValues <= MAX_TD64_BYTES)
+        return td512(inVals, outVals, nValues);
+    const uint32_t nElements=nValues / elementWidth;
+    const uint32_t nPlaneVals=nElements * elementWidth;
+    transposeByWidth(inVals, planeVals, nElements, elementWidth, 0);
+    memcpy(planeVals+nPlaneVals, inVals+nPlaneVals, nValues-nPlaneVals);
+    outVals[1] = 0;
+    outVals[outputOffset++] = TD512_EXT_TRANSPOSE;
+    outVals[outputOffset++] = (unsigned char)elementWidth;
+    if ((retBytes=td512td64Blocks(planeVals, outVals, nValues, outputOffset, TD512_MAX_OUTPUT_BYTES, &passFail, 1)) < 0)
+        return retBytes;
+    if (passFail == 0)
+        return td512(inVals, outVals, nValues);
+    td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, passFail);
+    return retBytes;
+} // end td512_transpose
+
+static inline uint32_t forBits(uint64_t value)
+{
+    // bits needed for value, 0 for 0
+    uint32_t nBits=0;
+    while (value)
+    {
+        nBits++;
+        value >>= 1;
+    }
+    return nBits;
+} // end forBits
+
+static inline uint32_t forOutputVarint(unsigned char *outVals, uint64_t value)
+{
+    // 7 bits per byte, low-order first, high bit set when more bytes follow
+    uint32_t nBytes=0;
+    while (value >= 0x80)
+    {
+        outVals[nBytes++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    outVals[nBytes++] = (unsigned char)value;
+    return nBytes;
+} // end forOutputVarint
+
+static inline void forOutputBits(unsigned char *outVals, uint32_t *outputOffset, uint64_t *outBits, uint32_t *nOutBits, uint64_t bits, uint32_t nBits)
+{
+    // append nBits, 0 to 64, to the 64-bit output buffer: more than 32 bits are output in two parts
+    if (nBits > 32)
+    {
+        forOutputBits(outVals, outputOffset, outBits, nOutBits, bits & 0xffffffff, 32);
+        bits >>= 32;
+        nBits -= 32;
+    }
+    *outBits |= bits << *nOutBits;
+    *nOutBits += nBits;
+    while (*nOutBits >= 8)
+    {
+        outVals[(*outputOffset)++] = (unsigned char)*outBits;
+        *outBits >>= 8;
+        *nOutBits -= 8;
+    }
+} // end forOutputBits
+
+static inline uint64_t forLoadInt(const unsigned char *inVals, const uint32_t intBytes)
+{
+    if (intBytes == 4)
+    {
+        uint32_t value;
+        memcpy(&value, inVals, 4);
+        return value;
+    }
+    uint64_t value;
+    memcpy(&value, inVals, 8);
+    return value;
+} // end forLoadInt
+
+static int32_t encodeFrameOfReference(const unsigned char *inVals, unsigned char *outVals, const uint32_t nInts, const uint32_t intBytes)
+{
+    // output the mode byte, a byte with the bit width and the delta bit, the reference as a varint,
+    // for delta the min gap as a varint, then each value less the reference in bit width bits
+    // values that do not decrease are coded as gaps from the previous value when that takes fewer bits
+    // returns the number of bytes output
+    uint64_t ints[TD512_MAX_U32_VALUES];
+    uint64_t minVal, maxVal, minGap=0, maxGap=0;
+    uint32_t sorted=1;
+    uint32_t i;
+    
+    minVal = maxVal = ints[0] = forLoadInt(inVals, intBytes);
+    for (i=1; i<nInts; i++)
+    {
+        const uint64_t value=forLoadInt(inVals+i*intBytes, intBytes);
+        ints[i] = value;
+        if (value < minVal)
+            minVal = value;
+        if (value > maxVal)
+            maxVal = value;
+        if (value < ints[i-1])
+            sorted = 0;
+    }
+    uint32_t nBits=forBits(maxVal-minVal);
+    uint32_t outputOffset=2;
+    uint32_t deltaMode=0;
+    if (sorted && nInts > 2)
+    {
+        minGap = maxGap = ints[1] - ints[0];
+        for (i=2; i<nInts; i++)
+        {
+            const uint64_t gap=ints[i] - ints[i-1];
+            if (gap < minGap)
+                minGap = gap;
+            if (gap > maxGap)
+                maxGap = gap;
+        }
+        const uint32_t nGapBits=forBits(maxGap-minGap);
+        if ((nInts-1) * nGapBits + 8 * (minGap ? (forBits(minGap)+6)/7 : 1) < nInts * nBits) // gaps plus the min gap varint
+        {
+            deltaMode = 1;
+            nBits = nGapBits;
+        }
+    }
+    outVals[0] = intBytes == 4 ? TD64_FOR_U32_MODE : TD64_FOR_U64_MODE;
+    outVals[1] = (unsigned char)(nBits | (deltaMode << 7));
+    if (deltaMode)
+    {
+        outputOffset += forOutputVarint(outVals+outputOffset, ints[0]);
+        outputOffset += forOutputVarint(outVals+outputOffset, minGap);
+        for (i=nInts-1; i>0; i--)
+            ints[i] -= ints[i-1] + minGap;
+        i = 1;
+    }
+    else
+    {
+        outputOffset += forOutputVarint(outVals+outputOffset, minVal);
+        for (i=0; i<nInts; i++)
+            ints[i] -= minVal;
+        i = 0;
+    }
+    if (nBits == 0)
+        return (int32_t)outputOffset; // all values or gaps are the same
+    uint64_t outBits=0;
+    uint32_t nOutBits=0;
+    for (; i<nInts; i++)
+        forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, ints[i], nBits);
+    if (nOutBits)
+        outVals[outputOffset++] = (unsigned char)outBits;
+    return (int32_t)outputOffset;
+} // end encodeFrameOfReference
+
+static int32_t td512OutputCoded(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *codedVals, const uint32_t nCodedBytes, const uint32_t extension)
+{
+    // output td512 info bytes for nValues and the coded values, which start with a TD64_ mode byte
+    // for more than 64 values, the extension byte follows the info bytes
+    // uses td512 when the coded values are not smaller
+    const uint32_t outputOffset=nValues <= MAX_TD64_BYTES ? 1 : (nValues <= 256 ? 3 : 4); // info bytes and extension byte
+    
+    if (nCodedBytes + outputOffset > nValues)
+        return td512(inVals, outVals, nValues);
+    if (nValues <= MAX_TD64_BYTES)
+    {
+        outVals[0] = (unsigned char)((nValues-1) << 1) | 128; // pass bit set
+    }
+    else
+    {
+        outVals[1] = 0;
+        outVals[outputOffset-1] = (unsigned char)extension;
+        td512OutputInfoBytes(outVals, nValues, TD512_EXTENDED_MODE, 1);
+    }
+    memcpy(outVals+outputOffset, codedVals, nCodedBytes);
+    return (int32_t)(outputOffset + nCodedBytes);
+} // end td512OutputCoded
+
+static int32_t td512FrameOfReference(const unsigned char *inVals, unsigned char *outVals, const uint32_t nInts, const uint32_t intBytes)
+{
+    // frame-of-reference coding of integers with td512 info bytes for nInts*intBytes values
+    unsigned char tempOutVals[TD512_MAX_U32_VALUES*4+32];
+    const int32_t nForBytes=encodeFrameOfReference(inVals, tempOutVals, nInts, intBytes);
+    return td512OutputCoded(inVals, outVals, nInts * intBytes, tempOutVals, (uint32_t)nForBytes, TD512_EXT_FRAME_OF_REFERENCE);
+} // end td512FrameOfReference
+
+int32_t td512_u32(const uint32_t *inVals, unsigned char *outVals, const uint32_t nInts)
+{
+    // compress 1 to TD512_MAX_U32_VALUES integers, decoded by td512d_u32 or by td512d as bytes
+    if ((nInts == 0) || (nInts > TD512_MAX_U32_VALUES))
+        return -128; // number of input values not supported
+    return td512FrameOfReference((const unsigned char *)inVals, outVals, nInts, 4);
+} // end td512_u32
+
+int32_t td512_u64(const uint64_t *inVals, unsigned char *outVals, const uint32_t nInts)
+{
+    // compress 1 to TD512_MAX_U64_VALUES integers, decoded by td512d_u64 or by td512d as bytes
+    if ((nInts == 0) || (nInts > TD512_MAX_U64_VALUES))
+        return -128; // number of input values not supported
+    return td512FrameOfReference((const unsigned char *)inVals, outVals, nInts, 8);
+} // end td512_u64
+
+static int32_t encodeXorFloat(const unsigned char *inVals, unsigned char *outVals, const uint32_t nFloats)
+{
+    // output the mode byte and the first value in 64 bits, then the XOR of each value with the previous
+    //  0 XOR is 0
+    // 10 meaningful bits fit within the leading and trailing zeros of the previous XOR: meaningful bits follow
+    // 11 5 bits of leading zeros, 6 bits of meaningful bit count less 1, and the meaningful bits
+    // returns the number of bytes output
+    uint32_t outputOffset=1;
+    uint64_t outBits=0;
+    uint32_t nOutBits=0;
+    uint32_t prevLeading=65; // no previous XOR
+    uint32_t prevTrailing=0;
+    uint64_t prevVal=forLoadInt(inVals, 8);
+    uint32_t i;
+    
+    outVals[0] = TD64_XOR_F64_MODE;
+    forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, prevVal, 64);
+    for (i=1; i<nFloats; i++)
+    {
+        const uint64_t thisVal=forLoadInt(inVals+i*8, 8);
+        const uint64_t xorVal=thisVal ^ prevVal;
+        prevVal = thisVal;
+        if (xorVal == 0)
+        {
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 0, 1);
+            continue;
+        }
+        uint32_t leading=0;
+        uint32_t trailing=0;
+        while (leading < 31 && (xorVal & ((uint64_t)1 << (63-leading))) == 0)
+            leading++;
+        while ((xorVal & ((uint64_t)1 << trailing)) == 0)
+            trailing++;
+        if (leading >= prevLeading && trailing >= prevTrailing)
+        {
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 1, 2); // 1 then 0
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, xorVal >> prevTrailing, 64-prevLeading-prevTrailing);
+        }
+        else
+        {
+            const uint32_t nMeaningfulBits=64-leading-trailing;
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 3 | leading << 2 | (nMeaningfulBits-1) << 7, 13);
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, xorVal >> trailing, nMeaningfulBits);
+            prevLeading = leading;
+            prevTrailing = trailing;
+        }
+    }
+    if (nOutBits)
+        outVals[outputOffset++] = (unsigned char)outBits;
+    return (int32_t)outputOffset;
+} // end encodeXorFloat
+
+static int32_t encodeDeltaOfDelta(const unsigned char *inVals, unsigned char *outVals, const uint32_t nInts)
+{
+    // output the mode byte, the first value as a varint and the first delta as a zigzag varint,
+    // then the zigzag difference of each delta from the previous delta
+    //    0 delta is the same
+    //   10 7 bits
+    //  110 9 bits
+    // 1110 12 bits
+    // 1111 64 bits
+    // returns the number of bytes output
+    uint32_t outputOffset=1;
+    uint64_t outBits=0;
+    uint32_t nOutBits=0;
+    uint64_t prevVal=forLoadInt(inVals, 8);
+    uint64_t prevDelta=0;
+    uint32_t i;
+    
+    outVals[0] = TD64_DOD_U64_MODE;
+    outputOffset += forOutputVarint(outVals+outputOffset, prevVal);
+    for (i=1; i<nInts; i++)
+    {
+        const uint64_t thisVal=forLoadInt(inVals+i*8, 8);
+        const uint64_t delta=thisVal - prevVal;
+        const int64_t dod=(int64_t)(delta - prevDelta);
+        const uint64_t zigzag=((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+        prevVal = thisVal;
+        prevDelta = delta;
+        if (i == 1)
+            outputOffset += forOutputVarint(outVals+outputOffset, zigzag);
+        else if (zigzag == 0)
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 0, 1);
+        else if (zigzag < 128)
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 1 | zigzag << 2, 9);
+        else if (zigzag < 512)
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 3 | zigzag << 3, 12);
+        else if (zigzag < 4096)
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 7 | zigzag << 4, 16);
+        else
+        {
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 15, 4);
+            forOutputBits(outVals, &outputOffset, &outBits, &nOutBits, zigzag, 64);
+        }
+    }
+    if (nOutBits)
+        outVals[outputOffset++] = (unsigned char)outBits;
+    return (int32_t)outputOffset;
+} // end encodeDeltaOfDelta
+
+int32_t td512_f64(const double *inVals, unsigned char *outVals, const uint32_t nFloats)
+{
+    // compress 1 to TD512_MAX_U64_VALUES doubles of a time series by the XOR of consecutive values
+    // decoded by td512d_f64 or by td512d as bytes
+    unsigned char tempOutVals[TD512_MAX_U64_VALUES*10+16];
+    if ((nFloats == 0) || (nFloats > TD512_MAX_U64_VALUES))
+        return -128; // number of input values not supported
+    const int32_t nCodedBytes=encodeXorFloat((const unsigned char *)inVals, tempOutVals, nFloats);
+    return td512OutputCoded((const unsigned char *)inVals, outVals, nFloats * 8, tempOutVals, (uint32_t)nCodedBytes, TD512_EXT_TIME_SERIES);
+} // end td512_f64
+
+int32_t td512_ts64(const uint64_t *inVals, unsigned char *outVals, const uint32_t nInts)
+{
+    // compress 1 to TD512_MAX_U64_VALUES timestamps by the difference of consecutive deltas
+    // decoded by td512d_u64 or by td512d as bytes
+    unsigned char tempOutVals[TD512_MAX_U64_VALUES*10+16];
+    if ((nInts == 0) || (nInts > TD512_MAX_U64_VALUES))
+        return -128; // number of input values not supported
+    const int32_t nCodedBytes=encodeDeltaOfDelta((const unsigned char *)inVals, tempOutVals, nInts);
+    return td512OutputCoded((const unsigned char *)inVals, outVals, nInts * 8, tempOutVals, (uint32_t)nCodedBytes, TD512_EXT_TIME_SERIES);
+} // end td512_ts64
+
+static int32_t td512Primed(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxOutBytes)
+{
+    // extended string mode continuing from the dictionary or stream window values
+    // string mode stops once its output does not fit in maxOutBytes, and nothing is written past maxOutBytes
+    // returns 0 when the values do not compress, or -151 if outVals does not have room
+    uint32_t nValuesRead;
+    uint32_t outputOffset;
+    uint32_t passFail=1;
+    int32_t retBits;
+    
+    memcpy(ctx->primeVals+ctx->nPrimeVals, inVals, nValues);
+    if (nValues <= 64)
+    {
+        if (maxOutBytes < 2)
+            return -151;
+        retBits = encodeExtendedStringModePrimed(ctx->primeVals, outVals+1, ctx->nPrimeVals+nValues, &nValuesRead, ctx->nPrimeVals, ctx->primeUniques, ctx->nPrimeUniques, maxOutBytes-1);
+        if (retBits <= 0)
+            return retBits == -102 ? -151 : retBits; // -102: string mode output does not fit in maxOutBytes
+        if (nValuesRead < nValues)
+            return 0; // too many uniques: no td64 blocks follow for <= 64 values
+        outVals[0] = (unsigned char)((nValues-1) << 1) | 128;
+        return (int32_t)(retBits+7)/8 + 1;
+    }
+    outputOffset = nValues <= 256 ? 3 : 4; // info bytes and string mode count
+    if (outputOffset >= maxOutBytes)
+        return -151;
+    outVals[1] = 0;
+    retBits = encodeExtendedStringModePrimed(ctx->primeVals, outVals+outputOffset, ctx->nPrimeVals+nValues, &nValuesRead, ctx->nPrimeVals, ctx->primeUniques, ctx->nPrimeUniques, maxOutBytes-outputOffset);
+    if (retBits <= 0)
+        return retBits == -102 ? -151 : retBits;
+    outVals[outputOffset-1] = (unsigned char)(nValuesRead-1); // lower 8 bits of count
+    if (nValues > 256)
+        outVals[1] |= (unsigned char)((nValuesRead-1)>>4)&0x10; // save upper bit in info byte 1 above extended mode bits
+    outputOffset += (uint32_t)(retBits+7)/8;
+    if ((retBits=td512td64Blocks(inVals+nValuesRead, outVals, nValues-nValuesRead, outputOffset, maxOutBytes, &passFail, 2)) < 0)
+        return retBits;
+    td512OutputInfoBytes(outVals, nValues, 2, passFail);
+    return retBits;
+} // end td512Primed
+
+static int32_t td512StreamString(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // extended string mode without the text and td64 checks, remaining values with td64
+    // returns 0 when the values do not compress
+    uint32_t nValuesRead;
+    uint32_t outputOffset=nValues <= 256 ? 3 : 4; // info bytes and string mode count
+    uint32_t passFail=1;
+    int32_t retBits;
+    
+    outVals[1] = 0;
+    if ((retBits=encodeExtendedStringMode(inVals, outVals+outputOffset, nValues, &nValuesRead)) <= 0)
+        return retBits;
+    outVals[outputOffset-1] = (unsigned char)(nValuesRead-1); // lower 8 bits of count
+    if (nValues > 256)
+        outVals[1] |= (unsigned char)((nValuesRead-1)>>4)&0x10; // save upper bit in info byte 1 above extended mode bits
+    outputOffset += (uint32_t)(retBits+7)/8;
+    if ((retBits=td512td64Blocks(inVals+nValuesRead, outVals, nValues-nValuesRead, outputOffset, TD512_MAX_OUTPUT_BYTES, &passFail, 2)) < 0)
+        return retBits;
+    td512OutputInfoBytes(outVals, nValues, 2, passFail);
+    return retBits;
+} // end td512StreamString
+
+static int32_t td512StreamSharedUniques(const td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // shared unique table of the previous block, not output again
+    // returns 0 when a value is not in the table
+    uint8_t val256[256]={0};
+    uint32_t sharedOccurrence[256];
+    uint32_t i;
+    
+    for (i=0; i<ctx->nPrevSharedUniques; i++)
+    {
+        val256[ctx->prevSharedUniques[i]] = 1;
+        sharedOccurrence[ctx->prevSharedUniques[i]] = i;
+    }
+    for (i=0; i<nValues; i++)
+        if (val256[inVals[i]] == 0)
+            return 0;
+    return td512SharedUniques(inVals, outVals, nValues, ctx->prevSharedUniques, sharedOccurrence, ctx->nPrevSharedUniques, TD512_EXT_SHARED_UNIQUES_PREVIOUS, -1, 0);
+} // end td512StreamSharedUniques
+
+static int32_t td512StreamTd64(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // td64 for all blocks without checktd64
+    uint32_t passFail=0;
+    int32_t retBytes;
+    
+    outVals[1] = 0;
+    if ((retBytes=td512td64Blocks(inVals, outVals, nValues, nValues <= 256 ? 2 : 3, TD512_MAX_OUTPUT_BYTES, &passFail, 1)) < 0)
+        return retBytes;
+    td512OutputInfoBytes(outVals, nValues, 0, passFail);
+    return retBytes;
+} // end td512StreamTd64
+
+static void td512UpdateStream(td512ctx *ctx, const unsigned char *encodedVals, const uint32_t nValues)
+{
+    // set the mode carried to the next block from the encoded block
+    // called by both td512_ctx and td512d_ctx so that their state is the same
+    const uint32_t inputOffset=nValues <= 256 ? 2 : 3;
+    uint32_t passFirst;
+    uint32_t extendedMode;
+    
+    ctx->prevMode = TD512_STREAM_NONE;
+    if (nValues <= 64)
+        return; // only one td64 block: nothing to carry
+    passFirst = nValues <= 256 ? (encodedVals[1] >> 4) & 1 : encodedVals[2] & 1;
+    extendedMode = (encodedVals[1] >> 2) & 3;
+    if (extendedMode == TD512_EXTENDED_MODE)
+    {
+        if (encodedVals[inputOffset] == TD512_EXT_SHARED_UNIQUES)
+        {
+            ctx->nPrevSharedUniques = (uint32_t)encodedVals[inputOffset+1] + 1;
+            memcpy(ctx->prevSharedUniques, encodedVals+inputOffset+2, ctx->nPrevSharedUniques);
+        }
+        if (encodedVals[inputOffset] <= TD512_EXT_SHARED_UNIQUES_PREVIOUS)
+            ctx->prevMode = TD512_STREAM_SHARED_UNIQUES;
+    }
+    else if (extendedMode == 0)
+    {
+        if (nValues >= MIN_VALUES_EXTENDED_MODE)
+            ctx->prevMode = TD512_STREAM_TD64; // selected by checktd64
+    }
+    else if (extendedMode == 2 && passFirst)
+        ctx->prevMode = TD512_STREAM_STRING; // text mode is not carried as checkTextMode is needed to find data for string mode
+} // end td512UpdateStream
+
+static int32_t td512Dictionary(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // td512 using the dictionary or stream window in ctx when there is one
+    // data not like the dictionary may do better with td512, so the smaller is used
+    int32_t retBytes;
+    int32_t retBytestd512;
+    unsigned char tempOutVals[TD512_MAX_OUTPUT_BYTES]; // td512 may output more bytes than values
+    if (ctx->nPrimeVals == 0 || nValues < MIN_VALUES_TO_COMPRESS)
+        return td512(inVals, outVals, nValues);
+    if ((retBytes=td512Primed(ctx, inVals, outVals, nValues, TD512_MAX_OUTPUT_BYTES)) == 0)
+        return td512(inVals, outVals, nValues);
+    if (retBytes < 0)
+        return retBytes;
+    if ((retBytestd512=td512(inVals, tempOutVals, nValues)) < 0)
+        return retBytestd512;
+    if (retBytestd512 < retBytes)
+    {
+        memcpy(outVals, tempOutVals, (uint32_t)retBytestd512);
+        return retBytestd512;
+    }
+    return retBytes;
+} // end td512Dictionary
+
+int32_t td512_ctx(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // td512 with the dictionary in ctx, and in stream mode, the mode of the previous block
+    // a block that does not compress in the carried mode is encoded as if it were the first
+    int32_t retBytes=0;
+    int32_t retBytesPrimed;
+    unsigned char tempOutVals[TD512_MAX_OUTPUT_BYTES]; // td512Primed may output more bytes than values
+    if (ctx->streamMode == 0)
+        return td512Dictionary(ctx, inVals, outVals, nValues);
+    if (nValues == 0 || nValues > 512)
+        return -128; // number of input values not supported
+    if (++ctx->nStreamBlocks >= TD512_STREAM_PROBE_INTERVAL)
+    {
+        // check the mode again in case the data has changed
+        ctx->nStreamBlocks = 0;
+        ctx->prevMode = TD512_STREAM_NONE;
+    }
+    switch (ctx->prevMode)
+    {
+        case TD512_STREAM_STRING:
+            if (nValues >= MIN_VALUES_EXTENDED_MODE && ctx->nPrimeVals == 0) // dictionary or window may do better
+                retBytes = td512StreamString(inVals, outVals, nValues);
+            break;
+        case TD512_STREAM_SHARED_UNIQUES:
+            if (nValues > MAX_TD64_BYTES)
+                retBytes = td512StreamSharedUniques(ctx, inVals, outVals, nValues);
+            break;
+        case TD512_STREAM_TD64:
+            if (nValues > MAX_TD64_BYTES)
+                retBytes = td512StreamTd64(inVals, outVals, nValues);
+            break;
+    }
+    if (retBytes < 0)
+        return retBytes;
+    if (retBytes == 0)
+    {
+        ctx->nStreamBlocks = 0;
+        if ((retBytes=td512Dictionary(ctx, inVals, outVals, nValues)) < 0)
+            return retBytes;
+    }
+    else if (ctx->nPrimeVals && nValues >= MIN_VALUES_TO_COMPRESS)
+    {
+        // strings from the window may do better than the carried mode
+        if ((retBytesPrimed=td512Primed(ctx, inVals, tempOutVals, nValues, sizeof(tempOutVals))) < 0)
+            return retBytesPrimed;
+        if (retBytesPrimed > 0 && retBytesPrimed < retBytes)
+        {
+            memcpy(outVals, tempOutVals, (uint32_t)retBytesPrimed);
+            retBytes = retBytesPrimed;
+        }
+    }
+    td512UpdateStream(ctx, outVals, nValues);
+    td512UpdateWindow(ctx, inVals, nValues);
+    return retBytes;
+} // end td512_ctx
+
+static int32_t td512dPrimed(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode extended string mode that continues from the dictionary or stream window values
+    int32_t retVals;
+    if (ctx == NULL || ctx->nPrimeVals == 0)
+        return -132; // encoded with a dictionary or stream window
+    if ((retVals=decodeExtendedStringModePrimed(inVals, ctx->primeVals, ctx->nPrimeVals+nValues, bytesProcessed, ctx->nPrimeVals, ctx->primeUniques, ctx->nPrimeUniques)) < 0)
+        return retVals;
+    memcpy(outVals, ctx->primeVals+ctx->nPrimeVals, nValues);
+    return retVals;
+} // end td512dPrimed
+
+static int32_t decodeSharedUniquesBlocks(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t passFail, uint32_t inputOffset, const unsigned char *sharedUniques, const uint32_t nSharedUniques, uint32_t *totalBytesProcessed)
+{
+    // decode td64 blocks that reference a unique table
+    uint32_t nBytesRemaining=nValues;
+    uint32_t outputOffset=0;
+    uint32_t bytesProcessed;
+    int32_t blockRetBytes;
+    
+    while (nBytesRemaining > 0)
+    {
+        const uint32_t nBlockVals=nBytesRemaining >= MAX_TD64_BYTES ? MAX_TD64_BYTES : nBytesRemaining;
+        if (passFail & 1)
+        {
+            if (inVals[inputOffset] == TD64_SHARED_UNIQUES_MODE)
+                blockRetBytes = decodeSharedUniquesMode(inVals+inputOffset, outVals+outputOffset, nBlockVals, sharedUniques, nSharedUniques, &bytesProcessed);
+            else
+                blockRetBytes = td64d(inVals+inputOffset, outVals+outputOffset, nBlockVals, &bytesProcessed);
+            if (blockRetBytes < 0)
+                return blockRetBytes;
+        }
+        else
+        {
+            // output uncompressed values
+            memcpy(outVals+outputOffset, inVals+inputOffset, nBlockVals);
+            bytesProcessed = nBlockVals;
+        }
+        nBytesRemaining -= nBlockVals;
+        passFail >>= 1;
+        inputOffset += bytesProcessed;
+        outputOffset += nBlockVals;
+    }
+    *totalBytesProcessed = inputOffset;
+    return (int32_t)nValues;
+} // end decodeSharedUniquesBlocks
+
+static int32_t decodeTransposedBlocks(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t passFail, const uint32_t inputOffset, uint32_t *totalBytesProcessed)
+{
+    // decode the td64 blocks of byte planes encoded by td512_transpose
+    unsigned char planeVals[512];
+    const uint32_t elementWidth=inVals[inputOffset];
+    int32_t retVals;
+    
+    if (elementWidth < 2 || elementWidth > TD512_MAX_TRANSPOSE_WIDTH)
+        return -137;
+    if ((retVals=decodeSharedUniquesBlocks(inVals, planeVals, nValues, passFail, inputOffset+1, NULL, 0, totalBytesProcessed)) < 0)
+        return retVals;
+    const uint32_t nElements=nValues / elementWidth;
+    const uint32_t nPlaneVals=nElements * elementWidth;
+    transposeByWidth(planeVals, outVals, nElements, elementWidth, 1);
+    memcpy(outVals+nPlaneVals, planeVals+nPlaneVals, nValues-nPlaneVals);
+    return retVals;
+} // end decodeTransposedBlocks
+
+static inline uint64_t forInputVarint(const unsigned char *inVals, uint32_t *inputOffset)
+{
+    uint64_t value=0;
+    uint32_t shift=0;
+    uint32_t inVal;
+    do
+    {
+        inVal = inVals[(*inputOffset)++];
+        value |= (uint64_t)(inVal & 0x7f) << shift;
+        shift += 7;
+    } while ((inVal & 0x80) && shift < 64);
+    return value;
+} // end forInputVarint
+
+static inline uint64_t forInputBits(const unsigned char *inVals, uint32_t *inputOffset, uint64_t *inBits, uint32_t *nInBits, const uint32_t nBits)
+{
+    // return the next nBits, 0 to 32, from the 64-bit input buffer
+    uint64_t bits;
+    while (*nInBits < nBits)
+    {
+        *inBits |= (uint64_t)inVals[(*inputOffset)++] << *nInBits;
+        *nInBits += 8;
+    }
+    bits = *inBits & (((uint64_t)1 << nBits) - 1);
+    *inBits >>= nBits;
+    *nInBits -= nBits;
+    return bits;
+} // end forInputBits
+
+static int32_t decodeFrameOfReference(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode integers encoded by encodeFrameOfReference to nValues bytes
+    const uint32_t intBytes=inVals[0] == TD64_FOR_U32_MODE ? 4 : 8;
+    const uint32_t nBits=inVals[1] & 0x7f;
+    const uint32_t deltaMode=inVals[1] >> 7;
+    const uint32_t nInts=nValues / intBytes;
+    uint32_t inputOffset=2;
+    uint64_t value, minGap=0;
+    uint32_t i=0;
+    
+    if (nInts * intBytes != nValues || nBits > intBytes * 8)
+        return -138; // corrupt frame-of-reference data
+    value = forInputVarint(inVals, &inputOffset);
+    if (deltaMode)
+    {
+        minGap = forInputVarint(inVals, &inputOffset);
+        if (intBytes == 4)
+        {
+            const uint32_t value32=(uint32_t)value;
+            memcpy(outVals, &value32, 4);
+        }
+        else
+            memcpy(outVals, &value, 8);
+        i = 1;
+    }
+    uint64_t inBits=0;
+    uint32_t nInBits=0;
+    for (; i<nInts; i++)
+    {
+        // more than 32 bits are read in two parts
+        const uint32_t nLowBits=nBits > 32 ? 32 : nBits;
+        uint64_t bits=forInputBits(inVals, &inputOffset, &inBits, &nInBits, nLowBits);
+        if (nBits > 32)
+            bits |= forInputBits(inVals, &inputOffset, &inBits, &nInBits, nBits-32) << 32;
+        if (deltaMode)
+            value += bits + minGap;
+        const uint64_t outValue=deltaMode ? value : value + bits;
+        if (intBytes == 4)
+        {
+            const uint32_t value32=(uint32_t)outValue;
+            memcpy(outVals+i*4, &value32, 4);
+        }
+        else
+            memcpy(outVals+i*8, &outValue, 8);
+    }
+    *bytesProcessed = inputOffset;
+    return (int32_t)nValues;
+} // end decodeFrameOfReference
+
+static int32_t decodeXorFloat(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode doubles encoded by encodeXorFloat to nValues bytes
+    const uint32_t nFloats=nValues / 8;
+    uint32_t inputOffset=1;
+    uint64_t inBits=0;
+    uint32_t nInBits=0;
+    uint32_t leading=0;
+    uint32_t nMeaningfulBits=0;
+    uint64_t thisVal;
+    uint32_t i;
+    
+    if (nFloats * 8 != nValues)
+        return -138; // not a whole number of doubles
+    thisVal = forInputBits(inVals, &inputOffset, &inBits, &nInBits, 32);
+    thisVal |= forInputBits(inVals, &inputOffset, &inBits, &nInBits, 32) << 32;
+    memcpy(outVals, &thisVal, 8);
+    for (i=1; i<nFloats; i++)
+    {
+        if (forInputBits(inVals, &inputOffset, &inBits, &nInBits, 1))
+        {
+            if (forInputBits(inVals, &inputOffset, &inBits, &nInBits, 1))
+            {
+                // new leading zeros and meaningful bit count
+                leading = (uint32_t)forInputBits(inVals, &inputOffset, &inBits, &nInBits, 5);
+                nMeaningfulBits = (uint32_t)forInputBits(inVals, &inputOffset, &inBits, &nInBits, 6) + 1;
+                if (leading + nMeaningfulBits > 64)
+                    return -138;
+            }
+            else if (nMeaningfulBits == 0)
+                return -138; // no previous XOR
+            uint64_t xorVal=forInputBits(inVals, &inputOffset, &inBits, &nInBits, nMeaningfulBits > 32 ? 32 : nMeaningfulBits);
+            if (nMeaningfulBits > 32)
+                xorVal |= forInputBits(inVals, &inputOffset, &inBits, &nInBits, nMeaningfulBits-32) << 32;
+            thisVal ^= xorVal << (64-leading-nMeaningfulBits);
+        }
+        memcpy(outVals+i*8, &thisVal, 8);
+    }
+    *bytesProcessed = inputOffset;
+    return (int32_t)nValues;
+} // end decodeXorFloat
+
+static int32_t decodeDeltaOfDelta(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode timestamps encoded by encodeDeltaOfDelta to nValues bytes
+    static const uint32_t dodBits[4]={7, 9, 12, 64};
+    const uint32_t nInts=nValues / 8;
+    uint32_t inputOffset=1;
+    uint64_t inBits=0;
+    uint32_t nInBits=0;
+    uint64_t thisVal, delta=0;
+    uint32_t i;
+    
+    if (nInts * 8 != nValues)
+        return -138; // not a whole number of integers
+    thisVal = forInputVarint(inVals, &inputOffset);
+    memcpy(outVals, &thisVal, 8);
+    for (i=1; i<nInts; i++)
+    {
+        uint64_t zigzag=0;
+        if (i == 1)
+            zigzag = forInputVarint(inVals, &inputOffset);
+        else
+        {
+            uint32_t nPrefixBits=0;
+            while (nPrefixBits < 4 && forInputBits(inVals, &inputOffset, &inBits, &nInBits, 1))
+                nPrefixBits++;
+            if (nPrefixBits == 4)
+            {
+                zigzag = forInputBits(inVals, &inputOffset, &inBits, &nInBits, 32);
+                zigzag |= forInputBits(inVals, &inputOffset, &inBits, &nInBits, 32) << 32;
+            }
+            else if (nPrefixBits)
+                zigzag = forInputBits(inVals, &inputOffset, &inBits, &nInBits, dodBits[nPrefixBits-1]);
+        }
+        delta += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        thisVal += delta;
+        memcpy(outVals+i*8, &thisVal, 8);
+    }
+    *bytesProcessed = inputOffset;
+    return (int32_t)nValues;
+} // end decodeDeltaOfDelta
+
+static int32_t decodeCodedValues(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode values output by td512OutputCoded according to the first byte
+    switch (inVals[0])
+    {
+        case TD64_FOR_U32_MODE:
+        case TD64_FOR_U64_MODE:
+            return decodeFrameOfReference(inVals, outVals, nValues, bytesProcessed);
+        case TD64_XOR_F64_MODE:
+            return decodeXorFloat(inVals, outVals, nValues, bytesProcessed);
+        case TD64_DOD_U64_MODE:
+            return decodeDeltaOfDelta(inVals, outVals, nValues, bytesProcessed);
+        case TD64_NUMERIC_TEXT_MODE:
+            return decodeNumericTextMode(inVals, outVals, nValues, bytesProcessed);
+        case TD64_HEX_MODE:
+        case TD64_BASE64_MODE:
+            return decodeAlphabetMode(inVals, outVals, nValues, bytesProcessed);
+        default:
+            return -138;
+    }
+} // end decodeCodedValues
+
+static int32_t decodeRunLength(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode tokens output by td512RunLength
+    uint32_t inputOffset=0;
+    uint32_t outputOffset=0;
+    while (outputOffset < nValues)
+    {
+        const uint32_t token=inVals[inputOffset++];
+        if (token & 0x80)
+        {
+            const uint32_t runLength=(token & 0x7f) + TD512_MIN_RUN_LENGTH;
+            if (outputOffset + runLength > nValues)
+                return -139; // corrupt run-length data
+            memset(outVals+outputOffset, inVals[inputOffset++], runLength);
+            outputOffset += runLength;
+        }
+        else
+        {
+            const uint32_t nLiterals=token + 1;
+            if (outputOffset + nLiterals > nValues)
+                return -139;
+            memcpy(outVals+outputOffset, inVals+inputOffset, nLiterals);
+            inputOffset += nLiterals;
+            outputOffset += nLiterals;
+        }
+    }
+    *bytesProcessed = inputOffset;
+    return (int32_t)nValues;
+} // end decodeRunLength
+
+static int32_t decodeUtf8Text(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t *bytesProcessed)
+{
+    // decode td512 of the page transform, then restore the lead byte of each sequence
+    unsigned char pageVals[512];
+    uint32_t pageLead=0;
+    uint32_t outputOffset=0;
+    uint32_t i=0;
+    
+    if ((inVals[0] & 1) && ((inVals[1] >> 2) & 3) == TD512_EXTENDED_MODE)
+    {
+        // page values are never encoded with the UTF-8 extension
+        const uint32_t nInfoValues=((inVals[0] >> 2) | (inVals[1] & 3) << 6) + ((inVals[0] & 3) == 1 ? 65 : 321);
+        if (inVals[nInfoValues <= 256 ? 2 : 3] == TD512_EXT_UTF8)
+            return -140;
+    }
+    const int32_t nPageVals=td512d(inVals, pageVals, bytesProcessed);
+    if (nPageVals < 0)
+        return nPageVals;
+    while (i < (uint32_t)nPageVals)
+    {
+        const uint32_t pageVal=pageVals[i];
+        uint32_t seqLength;
+        if (pageVal < 0x80)
+        {
+            if (outputOffset >= nValues)
+                return -140;
+            outVals[outputOffset++] = (unsigned char)pageVal;
+            i++;
+            continue;
+        }
+        if (pageVal == TD512_UTF8_ESCAPE)
+        {
+            if (outputOffset >= nValues || i+1 >= (uint32_t)nPageVals)
+                return -140;
+            outVals[outputOffset++] = pageVals[i+1];
+            i += 2;
+            continue;
+        }
+        if ((pageVal & 0xc0) == 0x80)
+        {
+            // same page as the previous sequence
+            if (pageLead == 0)
+                return -140;
+            seqLength = utf8SequenceLength(pageLead);
+            if (outputOffset+seqLength > nValues || i+seqLength-1 > (uint32_t)nPageVals)
+                return -140;
+            outVals[outputOffset] = (unsigned char)pageLead;
+            memcpy(outVals+outputOffset+1, pageVals+i, seqLength-1);
+            i += seqLength-1;
+        }
+        else
+        {
+            if ((seqLength=utf8SequenceLength(pageVal)) == 0 || outputOffset+seqLength > nValues || i+seqLength > (uint32_t)nPageVals)
+                return -140;
+            memcpy(outVals+outputOffset, pageVals+i, seqLength);
+            pageLead = pageVal;
+            i += seqLength;
+        }
+        outputOffset += seqLength;
+    }
+    if (outputOffset != nValues)
+        return -140; // corrupt UTF-8 text data
+    return (int32_t)nValues;
+} // end decodeUtf8Text
+
+static int32_t td512dExtendedMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t passFail, const uint32_t inputOffset, uint32_t *totalBytesProcessed, const td512ctx *ctx)
+{
+    // extension byte follows the info bytes
+    uint32_t nSharedUniques;
+    int32_t retVals;
+    switch (inVals[inputOffset])
+    {
+        case TD512_EXT_SHARED_UNIQUES:
+            // unique table follows the extension byte
+            nSharedUniques = (uint32_t)inVals[inputOffset+1] + 1;
+            if (nSharedUniques > MAX_UNIQUES)
+                return -130;
+            return decodeSharedUniquesBlocks(inVals, outVals, nValues, passFail, inputOffset+2+nSharedUniques, inVals+inputOffset+2, nSharedUniques, totalBytesProcessed);
+        case TD512_EXT_SHARED_UNIQUES_PREVIOUS:
+            if (ctx == NULL || ctx->nPrevSharedUniques == 0)
+                return -132; // encoded in stream mode
+            return decodeSharedUniquesBlocks(inVals, outVals, nValues, passFail, inputOffset+1, ctx->prevSharedUniques, ctx->nPrevSharedUniques, totalBytesProcessed);
+        case TD512_EXT_TRANSPOSE:
+            // element width follows the extension byte
+            return decodeTransposedBlocks(inVals, outVals, nValues, passFail, inputOffset+1, totalBytesProcessed);
+        case TD512_EXT_UTF8:
+            if ((retVals=decodeUtf8Text(inVals+inputOffset+1, outVals, nValues, totalBytesProcessed)) > 0)
+                *totalBytesProcessed += inputOffset + 1;
+            return retVals;
+        case TD512_EXT_RUN_LENGTH:
+            if ((retVals=decodeRunLength(inVals+inputOffset+1, outVals, nValues, totalBytesProcessed)) > 0)
+                *totalBytesProcessed += inputOffset + 1;
+            return retVals;
+        case TD512_EXT_FRAME_OF_REFERENCE:
+        case TD512_EXT_TIME_SERIES:
+        case TD512_EXT_NUMERIC_TEXT:
+        case TD512_EXT_ALPHABET:
+            // coded values start with a TD64_ mode byte
+            if ((retVals=decodeCodedValues(inVals+inputOffset+1, outVals, nValues, totalBytesProcessed)) > 0)
+                *totalBytesProcessed += inputOffset + 1;
+            return retVals;
+        default:
+            return -131; // extension not supported
+    }
+} // end td512dExtendedMode
+
+static inline int32_t td512dInternal(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed, td512ctx *ctx, const uint32_t wildCopy)
+{
+    // decompress td512 compressed data
+    // first bit or two indicate number of values from 1 to 512
+    //  0 1 to 64 values plus 1 pass/fail bit
+    // 01 65 to 320 values: excess 65 value, second byte holds upper two bits value
+    // 11 321 to 512 values: excess 321 second byte holds upper two bits value
+    // for 65 to 512 values: all modes bits in second byte and pass/fail in third byte
+    // extended mode 3: extension byte follows info bytes
+    // wildCopy 1: td64 blocks are decoded by td64d_slack, which may overwrite TD64D_OUTPUT_SLACK bytes past the values
+    // return number of bytes output
+    int32_t retBytes=0;
+    uint32_t nValues;
+    uint32_t bytesProcessed;
+    uint32_t passFail;
+    uint32_t firstByte=inVals[0];
+    
+    if ((firstByte & 1) == 0)
+    {
+        // decompress 1 to 64 values
+        nValues = ((firstByte >> 1) & 0x3f) + 1;
+        if (firstByte & 128)
+        {
+            if (inVals[1] == TD64_PRIMED_STRING_MODE)
+                retBytes = td512dPrimed(ctx, inVals+1, outVals, nValues, &bytesProcessed);
+            else if (inVals[1] == TD64_FOR_U32_MODE || inVals[1] == TD64_FOR_U64_MODE || inVals[1] == TD64_XOR_F64_MODE || inVals[1] == TD64_DOD_U64_MODE)
+                retBytes = decodeCodedValues(inVals+1, outVals, nValues, &bytesProcessed);
+            else
+                retBytes = wildCopy ? td64d_slack(inVals+1, outVals, nValues, &bytesProcessed) : td64d(inVals+1, outVals, nValues, &bytesProcessed);
+            if (retBytes < 0)
+                return retBytes; // bytesProcessed is not set on error
+            *totalBytesProcessed = bytesProcessed + 1;
+            return retBytes;
+        }
+        // uncompressed
+        memcpy(outVals, inVals+1, nValues);
+        *totalBytesProcessed = nValues + 1;
+        return (int32_t)nValues;
+    }
+    
+    uint32_t secondByte=inVals[1];
+    uint32_t thirdByte=inVals[2];
+    uint32_t inputOffset=2; // point past first two info bytes for <= 256 values
+    uint32_t outputOffset=0;
+    uint32_t nBytesRemaining;
+    int32_t blockRetBytes;
+    // decompress 65 to 512 values
+    if ((firstByte & 3) == 1)
+    {
+        // 65 to 320 values
+        nValues = ((firstByte >> 2) | (secondByte & 3) << 6) + 65;
+    }
+    else
+    {
+        // 321 to 512 values
+        nValues = ((firstByte >> 2) | (secondByte & 3) << 6) + 321;
+    }
+    nBytesRemaining = nValues;
+    if (nValues <= 256)
+    {
+        passFail = secondByte >> 4;
+    }
+    else
+    {
+        // pass fail in third byte for > 256 values
+        passFail = thirdByte;
+        inputOffset++;
+    }
+    const uint32_t extendedMode = (secondByte >> 2) & 3;
+    if (extendedMode == TD512_EXTENDED_MODE)
+        return td512dExtendedMode(inVals, outVals, nValues, passFail, inputOffset, totalBytesProcessed, ctx);
+    if (passFail == 0)
+    {
+        // all tests failed, copy all original values to output
+        if (extendedMode == 2)
+            inputOffset++;
+        memcpy(outVals, inVals+inputOffset, nValues);
+        *totalBytesProcessed = inputOffset + nValues;
+        return (int32_t)nValues;
+    }
+    if (nValues >= MIN_VALUES_EXTENDED_MODE || extendedMode == 2) // string mode with a dictionary may have fewer values
+    {
+        if (extendedMode == 1)
+        {
+            // process text mode
+            if (passFail & 1)
+            {
+                // decompress
+                blockRetBytes = decodeAdaptiveTextMode(inVals+inputOffset, outVals, nValues, &bytesProcessed);
+                nBytesRemaining = 0;
+            }
+            else
+            {
+                // no compression for this call: first 128 values are originals
+                memcpy(outVals, inVals+inputOffset, 128); //
+                bytesProcessed = 128;
+                blockRetBytes = 128;
+                nBytesRemaining = nValues - 128; // continue with td64
+            }
+            passFail >>= 1;
+            inputOffset += bytesProcessed;
+            outputOffset += blockRetBytes;
+            retBytes = blockRetBytes;
+        } // end process text mode
+        else if (extendedMode == 2)
+        {
+            // process string mode
+            uint32_t nValuesThisCall=inVals[inputOffset++]; // lower 8 bits of values read in first byte
+            if (nValues <= 256)
+                nValuesThisCall++; // 8-bit value
+            else
+            {
+                nValuesThisCall |= (inVals[1]&0x10) << 4; // 9th bit
+                nValuesThisCall++; // 9-bit value
+            }
+            if (passFail & 1)
+            {
+                if (inVals[inputOffset] == TD64_PRIMED_STRING_MODE)
+                    blockRetBytes=td512dPrimed(ctx, inVals+inputOffset, outVals+outputOffset, nValuesThisCall, &bytesProcessed);
+                else
+                    blockRetBytes=decodeExtendedStringMode(inVals+inputOffset, outVals+outputOffset, nValuesThisCall, &bytesProcessed);
+                if (blockRetBytes < 0)
+                    return blockRetBytes; // error return
+            }
+            else
+            {
+                // no compression for this block
+                memcpy(outVals, inVals+inputOffset, nValuesThisCall);
+                bytesProcessed = nValuesThisCall;
+                blockRetBytes = nValuesThisCall;
+            }
+            inputOffset += bytesProcessed;
+            outputOffset += nValuesThisCall;
+            passFail >>= 1;
+            retBytes = blockRetBytes;
+            nBytesRemaining -= blockRetBytes; // continue with td64
+        } // end process string mode
     }
     // td64 processing
     while (nBytesRemaining > 0)
@@ -541,7 +2189,10 @@ int32_t td512d(const unsigned char *inVals, unsigned char *outVals, uint32_t *to
         {
             // decode compressed values
             assert(nBytesRemaining >= MIN_VALUES_TO_COMPRESS); // error in compressed count
-            blockRetBytes = td64d(inVals+inputOffset, outVals+outputOffset, nBlockVals, &bytesProcessed);
+            if (wildCopy)
+                blockRetBytes = td64d_slack(inVals+inputOffset, outVals+outputOffset, nBlockVals, &bytesProcessed);
+            else
+                blockRetBytes = td64d(inVals+inputOffset, outVals+outputOffset, nBlockVals, &bytesProcessed);
             if (blockRetBytes < 0)
                 return blockRetBytes;
         }
@@ -562,4 +2213,566 @@ int32_t td512d(const unsigned char *inVals, unsigned char *outVals, uint32_t *to
     if (retBytes != (int32_t)nValues)
         return -129;
     return (int32_t)nValues;
-}
+} // end td512dInternal
+
+int32_t td512d(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed)
+{
+    return td512dInternal(inVals, outVals, totalBytesProcessed, NULL, 0);
+} // end td512d
+
+int32_t td512d_slack(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed)
+{
+    // td512d when outVals has TD64D_OUTPUT_SLACK bytes past the values, which may be overwritten,
+    // so that td64 blocks are output in whole groups of values without handling the final values separately
+    // returns the number of values decoded
+    return td512dInternal(inVals, outVals, totalBytesProcessed, NULL, 1);
+} // end td512d_slack
+
+int32_t td512d_view(const unsigned char *inVals, unsigned char *outVals, const unsigned char **viewVals, uint32_t *totalBytesProcessed)
+{
+    // td512d without copying the values of a block that td512 did not compress
+    // *viewVals points to the values in inVals for such a block, which outVals does not receive,
+    // else the values are decoded to outVals and *viewVals is outVals
+    // returns the number of values
+    const uint32_t firstByte=inVals[0];
+    uint32_t nValues;
+    uint32_t inputOffset;
+    
+    if ((firstByte & 1) == 0)
+    {
+        // 1 to 64 values
+        if (firstByte & 128)
+        {
+            *viewVals = outVals;
+            return td512d(inVals, outVals, totalBytesProcessed);
+        }
+        nValues = ((firstByte >> 1) & 0x3f) + 1;
+        inputOffset = 1;
+    }
+    else
+    {
+        // 65 to 512 values: passFail 0 for all blocks and no extension, as in td512dInternal
+        const uint32_t secondByte=inVals[1];
+        const uint32_t extendedMode=(secondByte >> 2) & 3;
+        nValues = ((firstByte >> 2) | (secondByte & 3) << 6) + ((firstByte & 3) == 1 ? 65 : 321);
+        inputOffset = nValues <= 256 ? 2 : 3;
+        if (extendedMode == TD512_EXTENDED_MODE || (nValues <= 256 ? secondByte >> 4 : inVals[2]) != 0)
+        {
+            *viewVals = outVals;
+            return td512d(inVals, outVals, totalBytesProcessed);
+        }
+        if (extendedMode == 2)
+            inputOffset++; // string mode count
+    }
+    *viewVals = inVals+inputOffset;
+    *totalBytesProcessed = inputOffset + nValues;
+    return (int32_t)nValues;
+} // end td512d_view
+
+static int32_t decodePrefixBlocks(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, uint32_t passFail, uint32_t inputOffset, const unsigned char *sharedUniques, const uint32_t nSharedUniques, const uint32_t nOutVals)
+{
+    // decode or copy td64 blocks up to the first nOutVals values, with sharedUniques for blocks that reference a unique table
+    unsigned char blockVals[MAX_TD64_BYTES+TD64D_OUTPUT_SLACK];
+    uint32_t outputOffset=0;
+    uint32_t bytesProcessed;
+    int32_t retVals;
+    
+    while (outputOffset < nOutVals)
+    {
+        const uint32_t nBlockVals=nValues-outputOffset >= MAX_TD64_BYTES ? MAX_TD64_BYTES : nValues-outputOffset;
+        const uint32_t nCopyVals=nOutVals-outputOffset < nBlockVals ? nOutVals-outputOffset : nBlockVals;
+        // the final block of the prefix is decoded to blockVals
+        unsigned char *blockOutVals=nCopyVals == nBlockVals ? outVals+outputOffset : blockVals;
+        if ((passFail & 1) == 0)
+        {
+            // uncompressed values
+            memcpy(outVals+outputOffset, inVals+inputOffset, nCopyVals);
+            bytesProcessed = nBlockVals;
+        }
+        else
+        {
+            if (sharedUniques != NULL && inVals[inputOffset] == TD64_SHARED_UNIQUES_MODE)
+                retVals = decodeSharedUniquesMode(inVals+inputOffset, blockOutVals, nBlockVals, sharedUniques, nSharedUniques, &bytesProcessed);
+            else if (blockOutVals == blockVals && (inVals[inputOffset] & 0x0f) == 0x07)
+            {
+                // text mode decodes one value at a time, so only the values of the prefix are decoded
+                if ((retVals=decodeAdaptiveTextMode(inVals+inputOffset, outVals+outputOffset, nCopyVals, &bytesProcessed)) < 0)
+                    return retVals;
+                break;
+            }
+            else if (blockOutVals == blockVals)
+                retVals = td64d_slack(inVals+inputOffset, blockVals, nBlockVals, &bytesProcessed);
+            else
+                retVals = td64d(inVals+inputOffset, blockOutVals, nBlockVals, &bytesProcessed);
+            if (retVals < 0)
+                return retVals;
+            if (blockOutVals == blockVals)
+                memcpy(outVals+outputOffset, blockVals, nCopyVals);
+        }
+        passFail >>= 1;
+        inputOffset += bytesProcessed;
+        outputOffset += nCopyVals;
+    }
+    return (int32_t)nOutVals;
+} // end decodePrefixBlocks
+
+int32_t td512d_prefix(const unsigned char *inVals, unsigned char *outVals, const uint32_t nPrefixVals)
+{
+    // decode only the first nPrefixVals values of a block, such as a type tag or a key prefix
+    // for uncompressed values and td64 blocks of 65 to 512 values, with or without a shared unique table,
+    // blocks past the prefix are skipped and uncompressed values are copied only up to it
+    // text mode, in a td64 block or for 65 to 512 values, is decoded only up to the prefix
+    // other modes are decoded whole to a temporary buffer
+    // returns the number of values output, the smaller of nPrefixVals and the number of values
+    unsigned char tempOutVals[512];
+    const uint32_t firstByte=inVals[0];
+    uint32_t nValues;
+    uint32_t nOutVals;
+    uint32_t bytesProcessed;
+    int32_t retVals;
+    
+    if (nPrefixVals == 0)
+        return 0;
+    if ((firstByte & 129) == 0)
+    {
+        // 1 to 64 uncompressed values
+        nValues = ((firstByte >> 1) & 0x3f) + 1;
+        nOutVals = nPrefixVals < nValues ? nPrefixVals : nValues;
+        memcpy(outVals, inVals+1, nOutVals);
+        return (int32_t)nOutVals;
+    }
+    if (firstByte & 1)
+    {
+        // 65 to 512 values, as in td512dInternal
+        const uint32_t secondByte=inVals[1];
+        const uint32_t extendedMode=(secondByte >> 2) & 3;
+        uint32_t inputOffset=2;
+        uint32_t passFail;
+        nValues = ((firstByte >> 2) | (secondByte & 3) << 6) + ((firstByte & 3) == 1 ? 65 : 321);
+        if (nValues <= 256)
+            passFail = secondByte >> 4;
+        else
+            passFail = inVals[inputOffset++];
+        nOutVals = nPrefixVals < nValues ? nPrefixVals : nValues;
+        if (extendedMode == 0)
+            return decodePrefixBlocks(inVals, outVals, nValues, passFail, inputOffset, NULL, 0, nOutVals);
+        if (extendedMode == 1 && (passFail & 1) && nValues >= MIN_VALUES_EXTENDED_MODE)
+        {
+            // extended text mode for all values
+            if ((retVals=decodeAdaptiveTextMode(inVals+inputOffset, outVals, nOutVals, &bytesProcessed)) < 0)
+                return retVals;
+            return (int32_t)nOutVals;
+        }
+        if (extendedMode == TD512_EXTENDED_MODE && inVals[inputOffset] == TD512_EXT_SHARED_UNIQUES)
+        {
+            // unique table follows the extension byte
+            const uint32_t nSharedUniques=(uint32_t)inVals[inputOffset+1] + 1;
+            if (nSharedUniques > MAX_UNIQUES)
+                return -130;
+            return decodePrefixBlocks(inVals, outVals, nValues, passFail, inputOffset+2+nSharedUniques, inVals+inputOffset+2, nSharedUniques, nOutVals);
+        }
+    }
+    // other modes are decoded whole
+    if ((retVals=td512d(inVals, tempOutVals, &bytesProcessed)) < 0)
+        return retVals;
+    nOutVals = nPrefixVals < (uint32_t)retVals ? nPrefixVals : (uint32_t)retVals;
+    memcpy(outVals, tempOutVals, nOutVals);
+    return (int32_t)nOutVals;
+} // end td512d_prefix
+
+int32_t td512d_len(const unsigned char *inVals, const uint32_t nInBytes, unsigned char *outVals, uint32_t *totalBytesProcessed)
+{
+    // td512d for a block in the nInBytes bytes of inVals, such as the end of a memory-mapped file or network buffer,
+    // reading no bytes past them
+    // td512d reads up to TD512D_INPUT_SLACK bytes past the end of a block, so when there are too few bytes for the
+    // longest block of its number of values and the slack, the bytes are copied to a buffer padded with 0s
+    // returns the number of values decoded, or -152 if the block is longer than nInBytes
+    unsigned char paddedVals[512+TD512_MAX_BLOCK_OVERHEAD+TD512D_INPUT_SLACK];
+    uint32_t nValues;
+    uint32_t nMaxBlockBytes;
+    int32_t retVals;
+    
+    if (nInBytes == 0)
+        return -152; // no compressed data
+    const uint32_t firstByte=inVals[0];
+    if ((firstByte & 1) == 0)
+    {
+        nValues = ((firstByte >> 1) & 0x3f) + 1;
+        if ((firstByte & 128) == 0 && nInBytes > nValues)
+            return td512d(inVals, outVals, totalBytesProcessed); // uncompressed: td512d reads the values only
+    }
+    else if (nInBytes < 2)
+        return -152; // 65 to 512 values have at least 2 info bytes
+    else
+        nValues = ((firstByte >> 2) | (inVals[1] & 3) << 6) + ((firstByte & 3) == 1 ? 65 : 321);
+    nMaxBlockBytes = nValues + TD512_MAX_BLOCK_OVERHEAD + TD512D_INPUT_SLACK;
+    if (nInBytes >= nMaxBlockBytes)
+        return td512d(inVals, outVals, totalBytesProcessed);
+    memcpy(paddedVals, inVals, nInBytes);
+    memset(paddedVals+nInBytes, 0, nMaxBlockBytes-nInBytes);
+    if ((retVals=td512d(paddedVals, outVals, totalBytesProcessed)) < 0)
+        return retVals;
+    if (*totalBytesProcessed > nInBytes)
+        return -152; // compressed data ends before the block
+    return retVals;
+} // end td512d_len
+
+int32_t td512d_ctx(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed)
+{
+    // td512d for values encoded by td512_ctx with the same dictionary loaded
+    // in stream mode, blocks must be decoded in the order encoded
+    const int32_t retVals=td512dInternal(inVals, outVals, totalBytesProcessed, ctx, 0);
+    if (retVals > 0 && ctx->streamMode)
+    {
+        td512UpdateStream(ctx, inVals, (uint32_t)retVals);
+        td512UpdateWindow(ctx, outVals, (uint32_t)retVals);
+    }
+    return retVals;
+} // end td512d_ctx
+
+int32_t td512d_u32(const unsigned char *inVals, uint32_t *outVals, uint32_t *totalBytesProcessed)
+{
+    // returns the number of integers decoded from td512_u32 output
+    const int32_t retVals=td512d(inVals, (unsigned char *)outVals, totalBytesProcessed);
+    if (retVals < 0)
+        return retVals;
+    if (retVals & 3)
+        return -138; // not a whole number of integers
+    return retVals / 4;
+} // end td512d_u32
+
+int32_t td512d_u64(const unsigned char *inVals, uint64_t *outVals, uint32_t *totalBytesProcessed)
+{
+    // returns the number of integers decoded from td512_u64 output
+    const int32_t retVals=td512d(inVals, (unsigned char *)outVals, totalBytesProcessed);
+    if (retVals < 0)
+        return retVals;
+    if (retVals & 7)
+        return -138; // not a whole number of integers
+    return retVals / 8;
+} // end td512d_u64
+
+int32_t td512d_f64(const unsigned char *inVals, double *outVals, uint32_t *totalBytesProcessed)
+{
+    // returns the number of doubles decoded from td512_f64 output
+    const int32_t retVals=td512d(inVals, (unsigned char *)outVals, totalBytesProcessed);
+    if (retVals < 0)
+        return retVals;
+    if (retVals & 7)
+        return -138; // not a whole number of doubles
+    return retVals / 8;
+} // end td512d_f64
+
+static inline void td4kPassFail(unsigned char *passFailBits, uint32_t *nPassFailBits, const uint32_t pass)
+{
+    // append a pass/fail bit to the td4k pass/fail bytes
+    if (pass)
+        passFailBits[*nPassFailBits >> 3] |= (unsigned char)(1 << (*nPassFailBits & 7));
+    (*nPassFailBits)++;
+} // end td4kPassFail
+
+static int32_t td4kBlocks(const unsigned char *inVals, unsigned char *outVals, uint32_t nBytesRemaining, uint32_t outputOffset, unsigned char *passFailBits, uint32_t *nPassFailBits, const uint32_t *sharedOccurrence, const uint32_t nSharedUniques)
+{
+    // encode blocks of 64 values with td64, or with the shared unique table when nSharedUniques > 0
+    // each block of MIN_VALUES_TO_COMPRESS or more values adds a pass/fail bit
+    // returns the output offset past the last block
+    const uint32_t allUniquesUsed=(1u << nSharedUniques) - 1;
+    uint32_t inputOffset=0;
+    int32_t retBits;
+    while (nBytesRemaining >= MIN_VALUES_TO_COMPRESS)
+    {
+        const uint32_t nBlockBytes=nBytesRemaining <= MAX_TD64_BYTES ? nBytesRemaining : MAX_TD64_BYTES;
+        if (nSharedUniques)
+        {
+            uint32_t uniquesUsed;
+            if ((retBits=encodeSharedUniquesMode(inVals+inputOffset, outVals+outputOffset, nBlockBytes, sharedOccurrence, nSharedUniques, &uniquesUsed)) < 0)
+                return retBits;
+            if (uniquesUsed != allUniquesUsed)
+            {
+                // fewer uniques in this block: td64 may encode with fewer bits
+                unsigned char tempOutVals[MAX_TD64_BYTES+16];
+                const int32_t retBitstd64=td64(inVals+inputOffset, tempOutVals, nBlockBytes);
+                if (retBitstd64 > 0 && retBitstd64 < retBits)
+                {
+                    retBits = retBitstd64;
+                    memcpy(outVals+outputOffset, tempOutVals, (uint32_t)(retBits+7)/8);
+                }
+            }
+        }
+        else if ((retBits=td64(inVals+inputOffset, outVals+outputOffset, nBlockBytes)) < 0)
+            return retBits; // error occurred
+        if (retBits == 0)
+        {
+            // failure leaves pass/fail bit 0
+            memcpy(outVals+outputOffset, inVals+inputOffset, nBlockBytes);
+            outputOffset += nBlockBytes;
+        }
+        else
+            outputOffset += (uint32_t)(retBits+7)/8;
+        td4kPassFail(passFailBits, nPassFailBits, retBits > 0);
+        inputOffset += nBlockBytes;
+        nBytesRemaining -= nBlockBytes;
+    }
+    if (nBytesRemaining > 0)
+    {
+        // final block is < MIN_VALUES_TO_COMPRESS: no pass/fail bit
+        memcpy(outVals+outputOffset, inVals+inputOffset, nBytesRemaining);
+        outputOffset += nBytesRemaining;
+    }
+    return (int32_t)outputOffset;
+} // end td4kBlocks
+
+static int32_t td4kStringSegment(const unsigned char *inVals, unsigned char *outVals, const uint32_t segmentStart, const uint32_t nSegmentVals, uint32_t outputOffset, unsigned char *passFailBits, uint32_t *nPassFailBits)
+{
+    // extended string mode for a segment, primed with up to TD4K_STRING_WINDOW preceding values,
+    // then td64 for any values following the 129th unique
+    // output is a 2-byte count of values read, then string mode, then td64 blocks
+    const uint32_t nWindowVals=segmentStart < TD4K_STRING_WINDOW ? segmentStart : TD4K_STRING_WINDOW;
+    uint32_t nValuesRead;
+    int32_t retBits;
+    
+    if (nWindowVals)
+    {
+        unsigned char primeUniques[MAX_UNIQUES_EXTENDED_STRING_MODE];
+        const uint32_t nPrimeUniques=getPrimeUniques(inVals+segmentStart-nWindowVals, nWindowVals, primeUniques);
+        retBits = encodeExtendedStringModePrimed(inVals+segmentStart-nWindowVals, outVals+outputOffset+2, nWindowVals+nSegmentVals, &nValuesRead, nWindowVals, primeUniques, nPrimeUniques, nSegmentVals+3); // as encodeExtendedStringMode, never stops at maxBytes
+    }
+    else
+        retBits = encodeExtendedStringMode(inVals+segmentStart, outVals+outputOffset+2, nSegmentVals, &nValuesRead);
+    if (retBits < 0)
+        return retBits;
+    td4kPassFail(passFailBits, nPassFailBits, retBits > 0);
+    if (retBits == 0)
+        return td4kBlocks(inVals+segmentStart, outVals, nSegmentVals, outputOffset, passFailBits, nPassFailBits, NULL, 0);
+    outVals[outputOffset] = (unsigned char)(nValuesRead-1);
+    outVals[outputOffset+1] = (unsigned char)((nValuesRead-1) >> 8);
+    outputOffset += 2 + (uint32_t)(retBits+7)/8;
+    return td4kBlocks(inVals+segmentStart+nValuesRead, outVals, nSegmentVals-nValuesRead, outputOffset, passFailBits, nPassFailBits, NULL, 0);
+} // end td4kStringSegment
+
+static int32_t td4kTextSegment(const unsigned char *inVals, unsigned char *outVals, const uint32_t nSegmentVals, uint32_t outputOffset, unsigned char *passFailBits, uint32_t *nPassFailBits)
+{
+    // extended text mode for a segment, or td64 blocks when it does not compress
+    uint32_t highBits=0;
+    uint32_t i;
+    int32_t retBits;
+    
+    for (i=0; i<nSegmentVals; i++)
+        highBits |= inVals[i];
+    if ((retBits=encodeAdaptiveTextMode(inVals, outVals+outputOffset, nSegmentVals, NULL, 1, (highBits & 0x80) == 0, nSegmentVals-16, -1)) < 0)
+        return retBits;
+    td4kPassFail(passFailBits, nPassFailBits, retBits > 0);
+    if (retBits == 0)
+        return td4kBlocks(inVals, outVals, nSegmentVals, outputOffset, passFailBits, nPassFailBits, NULL, 0);
+    return (int32_t)(outputOffset + (uint32_t)(retBits+7)/8);
+} // end td4kTextSegment
+
+static uint32_t td4kSelectMode(const unsigned char *inVals, const uint32_t nValues, unsigned char *sharedUniques, uint32_t *sharedOccurrence, uint32_t *nSharedUniques)
+{
+    // select one mode for all values from the checks td512 does on the first 512 values
+    // returns 0 td64  1 extended text mode  2 extended string mode  3 shared uniques
+    const uint32_t nCheckVals=nValues < TD4K_SEGMENT_VALUES ? nValues : TD4K_SEGMENT_VALUES;
+    uint32_t highBitCheck;
+    uint32_t checkTMret;
+    
+    *nSharedUniques = countSharedUniques(inVals, nValues, sharedUniques, sharedOccurrence);
+    if (nCheckVals < MIN_VALUES_EXTENDED_MODE)
+        return *nSharedUniques ? 3 : 0;
+    if ((checkTMret=checkTextMode(inVals, nCheckVals, &highBitCheck, -1)) == 1)
+        return 1;
+    if (checkTMret == 0)
+    {
+        unsigned char tempOutVals[MAX_TD64_BYTES];
+        td64Analysis analysis;
+        const uint32_t retBits=checktd64(inVals, tempOutVals, &analysis, -1);
+        if (retBits == 1 && *nSharedUniques)
+            return 3;
+        if (retBits)
+            return 0;
+    }
+    if (*nSharedUniques)
+    {
+        // string mode when it does better than a shared unique table for the first segment
+        unsigned char tempOutVals[TD4K_SEGMENT_VALUES];
+        uint32_t nValuesRead;
+        const int32_t retBits=encodeExtendedStringMode(inVals, tempOutVals, nCheckVals, &nValuesRead);
+        if (retBits <= 0 || nValuesRead < nCheckVals || (uint32_t)(retBits+7)/8 > sharedUniquesBytes(nCheckVals, *nSharedUniques))
+            return 3;
+    }
+    return 2;
+} // end td4kSelectMode
+
+int32_t td4k(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+{
+    // compress 1 to 4096 values with one mode selected for all values
+    // 3 info bytes: 12-bit value count excess 1, mode in bits 12-13, and the number of pass/fail bytes
+    // pass/fail bytes: one bit for each extended mode segment and td64 block
+    // shared unique mode: unique count excess 1 and uniques
+    // extended modes encode segments of TD4K_SEGMENT_VALUES, followed by td64 when they stop early or fail
+    // outVals must hold nValues + TD4K_MAX_OVERHEAD bytes
+    // returns number of bytes output
+    unsigned char passFailBits[TD4K_MAX_PASS_FAIL_BYTES]={0};
+    uint32_t nPassFailBits=0;
+    unsigned char sharedUniques[MAX_UNIQUES];
+    uint32_t sharedOccurrence[256];
+    uint32_t nSharedUniques;
+    uint32_t mode;
+    uint32_t nPassFailBytes;
+    uint32_t segmentStart;
+    int32_t outputOffset=3+TD4K_MAX_PASS_FAIL_BYTES; // moved down to follow the pass/fail bytes used
+    
+    if (nValues == 0 || nValues > TD4K_MAX_VALUES)
+        return -128; // number of input values not supported
+    mode = td4kSelectMode(inVals, nValues, sharedUniques, sharedOccurrence, &nSharedUniques);
+    if (mode == 3)
+    {
+        outVals[outputOffset++] = (unsigned char)(nSharedUniques-1);
+        memcpy(outVals+outputOffset, sharedUniques, nSharedUniques);
+        outputOffset += (int32_t)nSharedUniques;
+    }
+    if (mode == 0 || mode == 3)
+        outputOffset = td4kBlocks(inVals, outVals, nValues, (uint32_t)outputOffset, passFailBits, &nPassFailBits, sharedOccurrence, mode == 3 ? nSharedUniques : 0);
+    else
+    {
+        for (segmentStart=0; segmentStart<nValues && outputOffset>=0; segmentStart+=TD4K_SEGMENT_VALUES)
+        {
+            const uint32_t nSegmentVals=nValues-segmentStart < TD4K_SEGMENT_VALUES ? nValues-segmentStart : TD4K_SEGMENT_VALUES;
+            if (nSegmentVals < MIN_VALUES_EXTENDED_MODE)
+                outputOffset = td4kBlocks(inVals+segmentStart, outVals, nSegmentVals, (uint32_t)outputOffset, passFailBits, &nPassFailBits, NULL, 0);
+            else if (mode == 1)
+                outputOffset = td4kTextSegment(inVals+segmentStart, outVals, nSegmentVals, (uint32_t)outputOffset, passFailBits, &nPassFailBits);
+            else
+                outputOffset = td4kStringSegment(inVals, outVals, segmentStart, nSegmentVals, (uint32_t)outputOffset, passFailBits, &nPassFailBits);
+        }
+    }
+    if (outputOffset < 0)
+        return outputOffset; // error occurred
+    nPassFailBytes = (nPassFailBits+7) / 8;
+    memmove(outVals+3+nPassFailBytes, outVals+3+TD4K_MAX_PASS_FAIL_BYTES, (uint32_t)outputOffset-3-TD4K_MAX_PASS_FAIL_BYTES);
+    memcpy(outVals+3, passFailBits, nPassFailBytes);
+    outVals[0] = (unsigned char)(nValues-1);
+    outVals[1] = (unsigned char)((nValues-1) >> 8) | (unsigned char)(mode << 4);
+    outVals[2] = (unsigned char)nPassFailBytes;
+    return outputOffset - (int32_t)(TD4K_MAX_PASS_FAIL_BYTES - nPassFailBytes);
+} // end td4k
+
+static inline uint32_t td4kdPassFail(const unsigned char *passFailBits, uint32_t *nextPassFailBit)
+{
+    // next pass/fail bit from the td4k pass/fail bytes
+    const uint32_t pass=(passFailBits[*nextPassFailBit >> 3] >> (*nextPassFailBit & 7)) & 1;
+    (*nextPassFailBit)++;
+    return pass;
+} // end td4kdPassFail
+
+static int32_t td4kdBlocks(const unsigned char *inVals, unsigned char *outVals, uint32_t nBytesRemaining, uint32_t *inputOffset, const unsigned char *passFailBits, uint32_t *nextPassFailBit, const uint32_t nPassFailBits, const unsigned char *sharedUniques, const uint32_t nSharedUniques)
+{
+    // decode blocks of 64 values encoded by td4kBlocks
+    uint32_t outputOffset=0;
+    uint32_t bytesProcessed;
+    int32_t blockRetBytes;
+    while (nBytesRemaining >= MIN_VALUES_TO_COMPRESS)
+    {
+        const uint32_t nBlockVals=nBytesRemaining >= MAX_TD64_BYTES ? MAX_TD64_BYTES : nBytesRemaining;
+        if (*nextPassFailBit >= nPassFailBits)
+            return -136; // more blocks than pass/fail bits
+        if (td4kdPassFail(passFailBits, nextPassFailBit))
+        {
+            if (nSharedUniques && inVals[*inputOffset] == TD64_SHARED_UNIQUES_MODE)
+                blockRetBytes = decodeSharedUniquesMode(inVals+*inputOffset, outVals+outputOffset, nBlockVals, sharedUniques, nSharedUniques, &bytesProcessed);
+            else
+                blockRetBytes = td64d(inVals+*inputOffset, outVals+outputOffset, nBlockVals, &bytesProcessed);
+            if (blockRetBytes < 0)
+                return blockRetBytes;
+        }
+        else
+        {
+            // output uncompressed values
+            memcpy(outVals+outputOffset, inVals+*inputOffset, nBlockVals);
+            bytesProcessed = nBlockVals;
+        }
+        nBytesRemaining -= nBlockVals;
+        *inputOffset += bytesProcessed;
+        outputOffset += nBlockVals;
+    }
+    // final values < MIN_VALUES_TO_COMPRESS are not compressed
+    memcpy(outVals+outputOffset, inVals+*inputOffset, nBytesRemaining);
+    *inputOffset += nBytesRemaining;
+    return (int32_t)(outputOffset + nBytesRemaining);
+} // end td4kdBlocks
+
+int32_t td4kd(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed)
+{
+    // decompress td4k compressed data
+    // return number of values output
+    const uint32_t nValues=((uint32_t)inVals[0] | (uint32_t)(inVals[1] & 0x0f) << 8) + 1;
+    const uint32_t mode=(inVals[1] >> 4) & 3;
+    const uint32_t nPassFailBits=(uint32_t)inVals[2] * 8;
+    const unsigned char *passFailBits=inVals+3;
+    uint32_t nextPassFailBit=0;
+    uint32_t inputOffset=3+inVals[2];
+    uint32_t segmentStart;
+    uint32_t bytesProcessed;
+    int32_t retVals;
+    
+    if (inVals[2] > TD4K_MAX_PASS_FAIL_BYTES)
+        return -136;
+    if (mode == 0 || mode == 3)
+    {
+        uint32_t nSharedUniques=0;
+        const unsigned char *sharedUniques=NULL;
+        if (mode == 3)
+        {
+            nSharedUniques = (uint32_t)inVals[inputOffset++] + 1;
+            if (nSharedUniques > MAX_UNIQUES)
+                return -130;
+            sharedUniques = inVals+inputOffset;
+            inputOffset += nSharedUniques;
+        }
+        if ((retVals=td4kdBlocks(inVals, outVals, nValues, &inputOffset, passFailBits, &nextPassFailBit, nPassFailBits, sharedUniques, nSharedUniques)) < 0)
+            return retVals;
+        *totalBytesProcessed = inputOffset;
+        return (int32_t)nValues;
+    }
+    for (segmentStart=0; segmentStart<nValues; segmentStart+=TD4K_SEGMENT_VALUES)
+    {
+        const uint32_t nSegmentVals=nValues-segmentStart < TD4K_SEGMENT_VALUES ? nValues-segmentStart : TD4K_SEGMENT_VALUES;
+        uint32_t nValuesRead=0;
+        if (nSegmentVals >= MIN_VALUES_EXTENDED_MODE)
+        {
+            if (nextPassFailBit >= nPassFailBits)
+                return -136;
+            if (td4kdPassFail(passFailBits, &nextPassFailBit))
+            {
+                if (mode == 1)
+                {
+                    if ((retVals=decodeAdaptiveTextMode(inVals+inputOffset, outVals+segmentStart, nSegmentVals, &bytesProcessed)) < 0)
+                        return retVals;
+                    nValuesRead = nSegmentVals;
+                }
+                else
+                {
+                    const uint32_t nWindowVals=segmentStart < TD4K_STRING_WINDOW ? segmentStart : TD4K_STRING_WINDOW;
+                    nValuesRead = ((uint32_t)inVals[inputOffset] | (uint32_t)inVals[inputOffset+1] << 8) + 1;
+                    if (nValuesRead > nSegmentVals)
+                        return -136;
+                    inputOffset += 2;
+                    if (inVals[inputOffset] == TD64_PRIMED_STRING_MODE)
+                    {
+                        unsigned char primeUniques[MAX_UNIQUES_EXTENDED_STRING_MODE];
+                        const uint32_t nPrimeUniques=getPrimeUniques(outVals+segmentStart-nWindowVals, nWindowVals, primeUniques);
+                        retVals = decodeExtendedStringModePrimed(inVals+inputOffset, outVals+segmentStart-nWindowVals, nWindowVals+nValuesRead, &bytesProcessed, nWindowVals, primeUniques, nPrimeUniques);
+                    }
+                    else
+                        retVals = decodeExtendedStringMode(inVals+inputOffset, outVals+segmentStart, nValuesRead, &bytesProcessed);
+                    if (retVals < 0)
+                        return retVals;
+                }
+                inputOffset += bytesProcessed;
+            }
+        }
+        if ((retVals=td4kdBlocks(inVals, outVals+segmentStart+nValuesRead, nSegmentVals-nValuesRead, &inputOffset, passFailBits, &nextPassFailBit, nPassFailBits, NULL, 0)) < 0)
+            return retVals;
+    }
+    *totalBytesProcessed = inputOffset;
+    return (int32_t)nValues;
+} // end td4kd
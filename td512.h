@@ -66,6 +66,147 @@
  1. In tdString.c, moved the inline functions for bit output to td64_internal.h where they can also be used by functions in td64.c.
  2. In td64.c, implemented bit output improvements for encode AdaptiveTextMode and encodeStringMode.
  */
+// Notes for version 2.2.0:
+/*
+ 1. In td512.c, when all values have no more than 16 uniques, the uniques are output once following extended mode 3 and its extension byte TD512_EXT_SHARED_UNIQUES. Each td64 block then encodes indexes into that table (TD64_SHARED_UNIQUES_MODE), or uses td64 when its own uniques encode in fewer bits. This is done for 65 to 127 values, when checktd64 selects td64, and when string mode does not do better.
+ 2. In td64.c, added encodeSharedUniquesMode and decodeSharedUniquesMode.
+ */
+// Notes for version 2.2.1:
+/*
+ 1. In td512.c, checktd64 saves its analysis of the first 64 values (uniques, counts, high bit and text char checks) in a td64Analysis. When td64 is selected, the first block is encoded with td64Analyzed using that analysis rather than td64 building it again.
+ 2. In td64.c, moved text mode and the selection of modes after the uniques are known into td64TextMode and td64EncodeModes, which are shared by td64 and td64Analyzed.
+ */
+// Notes for version 2.2.2:
+/*
+ 1. In td512.c, added td512ctx with a dictionary loaded by td512LoadDictionary. td512_ctx encodes with extended string mode primed with the dictionary values (TD64_PRIMED_STRING_MODE) so that short records can take strings and uniques from the dictionary. td512d_ctx decodes with the same dictionary. Values that do not fit after the dictionary, or that do not compress, use td512.
+ 2. In tdString.c, extended string mode takes an optional dictionary that is processed for uniques and pairs but not output.
+ 3. In tdTrain.c, added td512TrainDictionary to select a dictionary from sample records.
+ */
+// Notes for version 2.2.3:
+/*
+ 1. In td64.c, text mode can encode with a table of 23 characters registered at run time with td64RegisterTextTable and selected with td64SelectTextTable. The info byte TD64_TRAINED_TEXT_MODE is followed by the table id, and the decoder looks up the table by that id. The characters counted for the text mode checks in td64 and td512 are those of the selected table.
+ 2. In tdTrain.c, added td64TrainTextTable, which orders the 23 most frequent characters of sample text so that the most frequent get the shortest codes.
+ */
+// Notes for version 2.2.4:
+/*
+ 1. In td512.c, added a stream mode with td512InitStreamCtx. td512_ctx carries the mode of the previous block (string, shared uniques or td64) to the next block and skips the checks that select it. A block that does not compress in the carried mode, and every TD512_STREAM_PROBE_INTERVAL blocks, is checked as before.
+ 2. In td512.c, a block whose values are all in the shared unique table of the previous block uses extension TD512_EXT_SHARED_UNIQUES_PREVIOUS, which does not output the table. td512d_ctx keeps the same state as td512_ctx from the encoded blocks, so blocks must be decoded in the order encoded.
+ */
+// Notes for version 2.2.5:
+/*
+ 1. In td512.c, td512SetStreamWindow keeps up to TD512_MAX_STREAM_WINDOW values of previous stream blocks in td512ctx. Extended string mode is primed with the window as it is with a dictionary, so strings may refer to previous blocks, and the smaller of that and the block encoded without the window is output. A loaded dictionary is the start of the window.
+ 2. In tdString.c, primed extended string mode accepts up to MAX_STRING_MODE_PRIME_VALUES prime values. String positions of 512 and higher are encoded in 10 to 13 bits, and a two-value string that costs more than two repeated values is output as a repeated value. td512_ctx no longer uses td512 when the dictionary plus the values to encode exceed 512.
+ */
+// Notes for version 2.2.6:
+/*
+ 1. In td512.c, added td4k and td4kd for 1 to 4096 values in one call. The mode is selected once with the td512 checks on the first 512 values. Three info bytes hold the 12-bit value count, the mode and the number of pass/fail bytes, which have one bit for each extended mode segment of 512 values and each td64 block. String mode segments after the first are primed with up to TD4K_STRING_WINDOW preceding values.
+ */
+// Notes for version 2.2.7:
+/*
+ 1. In td64.c, when td64 compresses less than 50%, the delta or XOR of values 1, 2, 4 or 8 bytes apart is encoded with td64 if it has a third fewer uniques than the input. The stride with the fewest uniques is used, and XOR is used when it has fewer uniques than delta. The first byte TD64_DELTA_MODE is followed by the stride byte and the td64 encoding of the delta values. This compresses counters and other slowly varying fields that have too many uniques for fixed bit coding.
+ */
+// Notes for version 2.2.8:
+/*
+ 1. In td512.c, added td512_transpose for arrays of elements of 2 to TD512_MAX_TRANSPOSE_WIDTH bytes. The values are transposed into byte planes that are encoded in blocks of 64 with td64, so the nearly constant high-order bytes of each element compress separately from the low-order bytes. Extension TD512_EXT_TRANSPOSE is followed by the element width, and td512d transposes the planes back.
+ */
+// Notes for version 2.2.9:
+/*
+ 1. In td512.c, added td512_u32 and td512_u64 for arrays of up to TD512_MAX_U32_VALUES and TD512_MAX_U64_VALUES integers, decoded by td512d_u32 and td512d_u64. The integers less their minimum are packed in the bits needed for the largest, or for integers that do not decrease, the gaps less the minimum gap are packed. For more than 64 bytes, extension TD512_EXT_FRAME_OF_REFERENCE is followed by the coded integers. For 64 or fewer bytes, the coded integers follow the info byte with first byte TD64_FOR_U32_MODE or TD64_FOR_U64_MODE. Integers that do not compress are encoded with td512.
+ */
+// Notes for version 2.2.10:
+/*
+ 1. In td512.c, added td512_f64 and td512d_f64 for up to TD512_MAX_U64_VALUES doubles of a time series. After the first value, the XOR of each value with the previous is output as one bit when 0, otherwise as its meaningful bits with the leading and trailing zero counts, or within those of the previous XOR.
+ 2. In td512.c, added td512_ts64 for up to TD512_MAX_U64_VALUES timestamps, decoded by td512d_u64. After the first value and delta, the difference of each delta from the previous is output in 1, 9, 12, 16 or 68 bits.
+ 3. Both use extension TD512_EXT_TIME_SERIES for more than 64 bytes, and first bytes TD64_XOR_F64_MODE and TD64_DOD_U64_MODE.
+ */
+// Notes for version 2.2.11:
+/*
+ 1. In td512.c, for 65 to 512 values with half or more equal to the previous value, td512 outputs extension TD512_EXT_RUN_LENGTH followed by tokens for runs of TD512_MIN_RUN_LENGTH to TD512_MAX_RUN_LENGTH values and for up to TD512_MAX_RUN_LITERALS literal values, when that is at most 1/8 of the values or smaller than the other modes. A block of 512 equal values is output in 12 bytes, and td512d decodes runs with memset. The previous td512 is now td512Encode.
+ */
+// Notes for version 2.2.12:
+/*
+ 1. In td64.c, added numeric text mode, TD64_NUMERIC_TEXT_MODE, which encodes digits, . - , : and the most frequent other value of the input in 4 bits, and other values in 12 bits after an escape code. It is tried when td64 compresses less than 50% and 3/4 of the values are digits or separators.
+ 2. In td512.c, when MIN_NUMERIC_TEXT_CHARS of the first 64 values are digits or separators, all values are encoded in numeric text mode after extension TD512_EXT_NUMERIC_TEXT, and output when smaller than the other modes.
+ */
+// Notes for version 2.2.13:
+/*
+ 1. In td64.c, added alphabet modes for values that are all hex characters of one case (TD64_HEX_MODE), or all base64 characters with + and / or with - and _ followed by up to two = (TD64_BASE64_MODE). The characters are encoded in 4 or 6 bits after the mode byte and a variant byte. They are tried before numeric text mode.
+ 2. In td512.c, 65 to 512 values that are all hex or base64 characters are encoded in alphabet mode after extension TD512_EXT_ALPHABET. Hex values are output without trying the other modes, as are hex blocks in td64. Base64 values are output when smaller than the other modes.
+ */
+// Notes for version 2.2.14:
+/*
+ 1. In td512.c, for 65 to 512 values of UTF-8 text with at least MIN_UTF8_SEQUENCES multibyte sequences, a page transform removes the lead byte of each sequence that has the same lead byte as the previous sequence, so that characters of one script take one byte fewer. The transformed values are encoded with td512 after extension TD512_EXT_UTF8 when that is smaller than the other modes. Values that are not part of a sequence, such as partial sequences at the ends of the block, are escaped with TD512_UTF8_ESCAPE.
+ */
+// Notes for version 2.2.15:
+/*
+ 1. In td64.c, text mode encodes each of 16 frequent bigrams, such as th and er, in one 6- to 8-bit code when that outputs fewer bits for up to the first 64 values. Bigrams are chosen for 64 values at a time as encoding one value at a time would choose them. Info byte TD64_BIGRAM_TEXT_MODE is used with the standard text characters and TD64_TRAINED_BIGRAM_MODE with a registered table.
+ 2. td64RegisterTextBigrams registers the bigrams of a table registered with td64RegisterTextTable, and td64TrainTextBigrams (tdTrain.c) selects the most frequent bigrams from sample text.
+ */
+// Notes for version 2.2.16:
+/*
+ 1. In td64.c, nibble mode TD64_NIBBLE_MODE encodes the index of the high nibble and of the low nibble of each value in the bits needed for the number of distinct high and low nibbles, which are stored as two 16-bit masks. It is tried with the other modes for compression less than 50%, and does best for blocks of more than MAX_UNIQUES values that have few distinct nibbles, such as binary protocol headers.
+ */
+// Notes for version 2.2.17:
+/*
+ 1. Added tdKeys.c with tdKeysEncode, tdKeysDecode and tdKeysGet for batches of up to TDKEYS_MAX_KEYS sorted keys. Each key is coded as the length of the prefix it shares with the previous key and its suffix, and the first key of every restart interval of up to TDKEYS_MAX_RESTART_INTERVAL keys is coded whole. The lengths and the suffixes of each interval are compressed with td512, and the offset of each interval is stored so that tdKeysGet decodes one key from its restart point.
+ */
+// Notes for version 2.2.18:
+/*
+ 1. Added tdTiny.c with tdTinyEncode and tdTinyDecode for batches of up to TDTINY_MAX_VALUES values of 1 to 15 bytes. Each value is output to one bitstream without byte alignment as a bit for whether it is encoded followed by the td5 encoding of 1 to 5 bytes, the td64 encoding of 6 to 15 bytes, or the value. Sizes are output once when all values have the same size, otherwise with td512 as 4-bit values.
+ 2. In td64.c, added td5Bits for the number of bits of a td5 encoding, which td5d does not return.
+ */
+// Notes for version 2.2.19:
+/*
+ 1. In td64.c, added td64_estimate for the number of bits td64 is expected to output without generating output. Modes are selected as in td64 with their sizes computed from the uniques and counts of the values, which is exact for td5, fixed bit coding, 7-bit, hex, base64, numeric text and nibble modes. Single value and string modes return the most bits td64 outputs, and text mode is estimated without bigrams.
+ 2. In td512.c, added td512_estimate for the number of bytes td512 is expected to output: its info bytes plus td64_estimate of each block of 64 values. The extended modes of td512 for 65 to 512 values may output fewer.
+ 3. In td64.c, moved the size computations of numeric text mode and nibble mode and the stride selection of delta mode into numericTextBits, nibbleMasks and deltaModeVals, which are shared with td64_estimate.
+ */
+// Notes for version 2.2.20:
+/*
+ 1. In td512.c, added td512_max for output that must fit in maxOutBytes, which may be less than the number of values. The values are encoded into a temporary buffer of TD512_MAX_OUTPUT_BYTES that is copied to outVals only when the output fits, else -151 is returned. td512Encode stops as soon as the values already encoded fill maxOutBytes.
+ 2. The previous td512 is now td512Bounded, which td512 calls with TD512_MAX_OUTPUT_BYTES. td512 may output several bytes more than the number of values, mainly for text mode with many values not in its table, and text mode may write more bytes before it fails, so TD512_MAX_OUTPUT_BYTES allows 11 bits, the longest text mode code, for each of 512 values plus the info bytes.
+ */
+// Notes for version 2.2.21:
+/*
+ 1. In td512.c, added td512d_len, which takes the number of bytes of compressed data and reads no bytes past them, for decoding from the end of a memory-mapped file or network buffer. td512d may read up to TD512D_INPUT_SLACK bytes past the end of a block, such as the byte read ahead by decodeAdaptiveTextMode, so when fewer bytes than the largest block plus TD512D_INPUT_SLACK remain, they are copied to a buffer padded with 0s before calling td512d. Otherwise td512d decodes directly from inVals. -152 is returned when the block is longer than the compressed data.
+ */
+// Notes for version 2.2.22:
+/*
+ 1. In td64.c, added td64d_slack and in td512.c, td512d_slack, for output buffers with TD64D_OUTPUT_SLACK bytes past the values, which may be overwritten. Fixed bit coding then outputs whole groups of 4 or 8 values without the checks for the final values, and the number of bytes processed is computed from the number of values and uniques. The previous td64d is now td64dInternal.
+ 2. In td64.c, decode7bits copies the final values, which are full bytes, with memcpy.
+ */
+// Notes for version 2.2.23:
+/*
+ 1. In td512.c, added td512d_view, which returns a pointer to the values in the compressed data for a block that td512 did not compress, which is all values of 1 to 64 values with the pass/fail bit 0 or of 65 to 512 values with all pass/fail bits 0 and no extension. Other blocks are decoded to outVals by td512d, and the pointer returned is outVals.
+ */
+// Notes for version 2.2.24:
+/*
+ 1. In td512.c, added td512d_prefix, which decodes only the first nPrefixVals values of a block, such as a type tag or a key prefix. For uncompressed values and for td64 blocks of 65 to 512 values, with or without TD512_EXT_SHARED_UNIQUES, blocks past the prefix are skipped, the final block of the prefix is decoded to a temporary buffer, and uncompressed values are copied only up to the prefix. Other modes are decoded whole by td512d to a temporary buffer.
+ */
+// Notes for version 2.2.25:
+/*
+ 1. In td64.c, td64_estimate was below td64 for text mode with bigrams and selected modes with its own copy of td64Encode. The body of td64 is now td64SelectModes, which td64 and td64_estimate share: with sizeOnly set, fixed bit coding, 7-bit, hex, base64, numeric text and nibble modes return their bits without output, while text, string and single value modes are encoded into a temporary buffer. td64_estimate now returns exactly the bits of td64, and 0 when td64 does not compress, in which case the values are stored as they are.
+ 2. In td64.c, moved the size computations of fixed bit coding, 7-bit, alphabet and nibble modes into fixedBitBits, sevenBitBits, alphabetModeBits and nibbleModeBits, shared by the encoders and the sizeOnly selection.
+ 3. In td512.c, td512_estimate added only the td64 blocks, which is below td512 when it selects shared uniques, text mode or string mode. td512Encode and td512Bounded now take sizeOnly, which sizes the td64 blocks with td64_estimate, and td512_estimate calls td512Bounded with sizeOnly set so that it returns exactly the bytes of td512.
+ 4. In td512.c, 65 to 127 values with at most MAX_UNIQUES uniques were output with a shared unique table even when larger than td64 blocks. The table is now used only when sharedUniquesBytes is fewer than td64BlocksBytes, the bytes of the td64 blocks from td64_estimate.
+ 5. In td64_internal.h, encode7bitsInternal and decode7bitsInternal are static inline so that td512.c includes the header without unused function warnings.
+ */
+// Notes for version 2.2.26:
+/*
+ 1. td512.h includes only the headers of the codec. Callers of td512TrainDictionary, td64TrainTextTable and td64TrainTextBigrams include tdTrain.h, of tdKeysEncode, tdKeysDecode and tdKeysGet tdKeys.h, and of tdTinyEncode and tdTinyDecode tdTiny.h.
+ 2. In td512.c, td512Dictionary encoded td512 into a buffer of 516 bytes, which td512 overflows for blocks of 512 values with many high-bit values that it outputs as more bytes than values. The buffer is now TD512_MAX_OUTPUT_BYTES. In main.c, test_td512_ctx_65to512 compresses and decompresses random values and text with high-bit values for 65 to 512 values with a dictionary.
+ 3. In td512.c, td512_ctx encoded td512Primed into a buffer of 516 bytes. The buffer is now TD512_MAX_OUTPUT_BYTES, and td512Primed and td512td64Blocks take maxOutBytes, the size of outVals: string mode is not started without room for 1 byte more than the values, and no td64 block without room for 2 bytes per value, which td64 may write before it fails, else -151 is returned. test_td512_ctx_65to512 also encodes each block twice in stream mode, so that the second is encoded in the carried mode and with the first as the window.
+ 4. In td512.c, td512Bounded scanned every block of 65 to 512 values with checkUtf8Text, including blocks of ASCII text. countRepeatedValues now also returns the OR of the values, and checkUtf8Text is called only when it has the high bit set.
+ 5. In td512.c, td512d_len copied the compressed data to a buffer of TD512_MAX_OUTPUT_BYTES plus TD512D_INPUT_SLACK padded with 0s whenever it was shorter, which is every block when nInBytes is its exact length. The number of values is now read from the info bytes first: the data is copied only when nInBytes is less than the longest block of that number of values, nValues plus TD512_MAX_BLOCK_OVERHEAD, plus TD512D_INPUT_SLACK, and padded only to that size. Uncompressed blocks of 1 to 64 values, of which td512d reads no bytes past the values, are decoded without the copy.
+ 6. In td64.c, td64DeltaMode counted the uniques of the deltas of every stride for every block that compressed less than 50%, which slowed td64 on text 4 to 7 times for blocks of 64 values. deltaModeStride first checks the first 8 deltas of strides 1, 2, 4 and 8, 8 at a time in 64-bit values, and the last 8 for a stride with 3 steady deltas, deltas from -4 to 4 followed by another. The uniques are only counted for the stride with the most steady deltas if it has 6, which text and random data rarely have, and only that stride is encoded.
+ 7. In td512.c, td512Encode called text mode with nBytesRemaining-16 and string mode without a bound, and the run-length, alphabet, numeric text and UTF-8 extensions ignored maxOutBytes, so td512_max encoded these modes completely before returning -151. Text mode now stops at the smaller of nBytesRemaining-16 and the bytes left in maxOutBytes. String mode is called with encodeExtendedStringModeMax, and encodeExtendedStringModePrimed takes maxBytes, so that it stops at the next unique once the output does not fit; td512Primed passes the bytes left rather than requiring 1 byte more than the values. td512AlphabetMode sizes its output with alphabetModeBits before encoding, and the other extensions stop at maxOutBytes. Each returns -151. checktd64 also calls encodeExtendedStringModeMax, since string mode could write 65 bytes for 64 values into its buffer of MAX_TD64_BYTES.
+ 8. In td64.c, tdString.c and td512.c, td64_estimate and td512_estimate encoded text, string and single value modes and the td512 extensions into scratch buffers, so that they ran at the speed of td64 and td512. These modes now take sizeOnly: thisOutIx2Sized and esmOutputRemainderSized advance the output index as thisOutIx2 and esmOutputRemainder do without writing, so that text mode stops at the same escaped value and string mode at the same unique, and adaptiveTextModeBits, encodeExtendedStringModeMax, sharedUniquesModeBits and numericTextModeBits return the bits without output. encodeSingleValueMode compressed one value past the non-single values, which was left over in outVals, so that the size of a block could differ between calls; that value is now 0.
+ 9. In td64.c, bigram text mode generated the codes of the first 64 values of every text block in bigramTextSaves and again in encodeBigramTextMode, which slowed text mode encode about 30%. bigramTextSaves first counts the bigrams that start in the first 32 values and sizes bigram text mode only when at least 2 do, and encodeBigramTextMode uses the codes it generated for the first 64 values. bigramChunkCodes finds the starts of bigrams in the same loop as the codes.
+ 10. In td64.c, td64SelectTextTable selected the registered text table for td64 and td512 in a static variable shared by every thread. It is replaced by td64_table and td512_table, which take the table id, and td64 and td512 always use the predefined tables. The id is passed to the text mode checks and encoders, and checktd64 saves it in td64Analysis for td64Analyzed. td64CheckTextTable returns -14 for an id that is not -1 or a registered table.
+ 11. In td64.c and td512.c, decodeBigramTextMode returned -18 when the values to decode ended within a bigram, and decodeAdaptiveTextMode read past its loop for fewer than 3 values, so text mode could not be decoded for a prefix of its values. A bigram that starts at the last value now outputs only its first value. td512d_prefix decodes only the prefix of a text mode td64 block, and of extended text mode for 65 to 512 values, rather than the whole block, which is 4 to 9 times faster for short prefixes of 128 to 512 values of English text. test_td512d_prefix in main.c checks every prefix of 1 to 512 values.
+ 12. In main.c, which includes tdKeys.h, test_td512_max encodes text and random values of 1 to 512 values with td512_max into exactly the bytes td512 outputs and into one byte less, which returns -151. test_tdKeys encodes keys of 4 to 40 bytes for restart intervals of 1 to 128 the same way, which returns -143 for one byte less, and checks tdKeysDecode and tdKeysGet for every key.
+ 13. In tdTiny.c, tdTinyEncode returned -149 unless maxOutBytes had room for every value output uncompressed with its bit, so a buffer of exactly the bytes output was rejected. tinyBitsFit now checks each value as it is output. In main.c, which includes tdTiny.h, test_tdTiny encodes text and random values of mixed sizes from 1 to 15 bytes and of one size into exactly the bytes output and into one byte less, which returns -149, and decodes them.
+ */
 #ifndef td512_h
 #define td512_h
 
@@ -73,15 +214,88 @@
 #include "tdString.h"
 #include <unistd.h>
 
-#define TD512_VERSION "v2.1.7"
+#define TD512_VERSION "v2.2.26"
 #define MIN_VALUES_EXTENDED_MODE 128
 #define MIN_UNIQUES_SINGLE_VALUE_MODE_CHECK 14
 #define MIN_VALUES_TO_COMPRESS 16
+#define TD512_MAX_OUTPUT_BYTES 1024 // room for the bytes td512 writes for up to 512 values
+#define TD512D_INPUT_SLACK 8 // bytes past the end of a block that td512d may read
+#define TD512_MAX_BLOCK_OVERHEAD 16 // bytes of a td512 block beyond its number of values
+#define TD512_EXTENDED_MODE 3 // extended mode bits value that indicates an extension byte follows the info bytes
+#define TD512_EXT_SHARED_UNIQUES 0 // extension: td64 blocks reference one unique table
+#define TD512_EXT_SHARED_UNIQUES_PREVIOUS 1 // extension: td64 blocks reference the unique table of the previous stream block
+#define TD512_EXT_TRANSPOSE 2 // extension: td64 blocks of the byte planes of fixed-width elements
+#define TD512_MAX_TRANSPOSE_WIDTH 16 // max element width for td512_transpose
+#define TD512_EXT_FRAME_OF_REFERENCE 3 // extension: integers coded by td512_u32 or td512_u64
+#define TD512_EXT_TIME_SERIES 4 // extension: doubles coded by td512_f64 or timestamps coded by td512_ts64
+#define TD512_EXT_RUN_LENGTH 5 // extension: runs of one value and literals
+#define TD512_MIN_RUN_LENGTH 4
+#define TD512_MAX_RUN_LENGTH (127+TD512_MIN_RUN_LENGTH)
+#define TD512_MAX_RUN_LITERALS 128
+#define TD512_EXT_NUMERIC_TEXT 6 // extension: numeric text mode for all values
+#define TD512_EXT_ALPHABET 7 // extension: hex or base64 alphabet mode for all values
+#define TD512_EXT_UTF8 8 // extension: td512 of UTF-8 text with lead bytes removed
+#define TD512_UTF8_ESCAPE 0xff // page transform value before a value that is not part of a UTF-8 sequence
+#define MIN_UTF8_SEQUENCES 8 // multibyte sequences in a block to try the page transform
+#define MIN_NUMERIC_TEXT_CHARS 48 // digits and separators in the first 64 values to try numeric text mode
+#define TD512_MAX_U32_VALUES 128
+#define TD512_MAX_U64_VALUES 64
+#define TD512_MAX_DICTIONARY_VALUES 256 // values loaded by td512LoadDictionary
+#define TD512_MAX_STREAM_WINDOW MAX_STRING_MODE_PRIME_VALUES // values of previous stream blocks for string references
+#define TD512_STREAM_PROBE_INTERVAL 16 // stream blocks between full mode checks
+// stream mode carried from the previous block
+#define TD512_STREAM_NONE 0
+#define TD512_STREAM_STRING 2
+#define TD512_STREAM_SHARED_UNIQUES 3
+#define TD512_STREAM_TD64 4
+#define TD4K_MAX_VALUES 4096
+#define TD4K_SEGMENT_VALUES 512 // values encoded by each extended mode call
+#define TD4K_STRING_WINDOW 1024 // preceding values that prime string mode for a segment
+#define TD4K_MAX_PASS_FAIL_BYTES 9 // 8 segments with 1 extended mode bit and 8 td64 block bits each
+#define TD4K_MAX_OVERHEAD 32 // output bytes beyond the number of values
 //#define TD512_TEST_MODE // enable this macro to generate statistics
 
+typedef struct
+{
+    // state shared by td512_ctx and td512d_ctx calls: init with td512InitCtx
+    unsigned char primeVals[TD512_MAX_STREAM_WINDOW+512]; // dictionary or stream window values followed by the values being encoded or decoded
+    uint32_t nPrimeVals; // 0 when no dictionary is loaded and the window is empty
+    unsigned char primeUniques[MAX_UNIQUES_EXTENDED_STRING_MODE]; // prime value uniques in order of first occurrence
+    uint32_t nPrimeUniques;
+    uint32_t nStreamWindowVals; // set by td512SetStreamWindow, 0 for no window
+    uint32_t streamMode; // 1 when set by td512InitStreamCtx
+    uint32_t prevMode; // TD512_STREAM_ mode of the previous block
+    uint32_t nStreamBlocks; // blocks encoded since the last full mode check
+    unsigned char prevSharedUniques[MAX_UNIQUES]; // shared unique table of the previous block
+    uint32_t nPrevSharedUniques; // 0 when no table has been output
+} td512ctx;
+
 extern const uint32_t predefinedBitTextChars[256];
 
 int32_t td512(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues);
 int32_t td512d(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed);
+int32_t td512d_len(const unsigned char *inVals, const uint32_t nInBytes, unsigned char *outVals, uint32_t *totalBytesProcessed);
+int32_t td512d_slack(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed);
+int32_t td512d_view(const unsigned char *inVals, unsigned char *outVals, const unsigned char **viewVals, uint32_t *totalBytesProcessed);
+int32_t td512d_prefix(const unsigned char *inVals, unsigned char *outVals, const uint32_t nPrefixVals);
+int32_t td512_estimate(const unsigned char *inVals, const uint32_t nValues);
+int32_t td512_max(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxOutBytes);
+int32_t td512_table(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId);
+int32_t td512_transpose(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t elementWidth);
+int32_t td512_u32(const uint32_t *inVals, unsigned char *outVals, const uint32_t nInts);
+int32_t td512_u64(const uint64_t *inVals, unsigned char *outVals, const uint32_t nInts);
+int32_t td512_f64(const double *inVals, unsigned char *outVals, const uint32_t nFloats);
+int32_t td512_ts64(const uint64_t *inVals, unsigned char *outVals, const uint32_t nInts);
+int32_t td512d_u32(const unsigned char *inVals, uint32_t *outVals, uint32_t *totalBytesProcessed);
+int32_t td512d_u64(const unsigned char *inVals, uint64_t *outVals, uint32_t *totalBytesProcessed);
+int32_t td512d_f64(const unsigned char *inVals, double *outVals, uint32_t *totalBytesProcessed);
+void td512InitCtx(td512ctx *ctx);
+void td512InitStreamCtx(td512ctx *ctx);
+int32_t td512SetStreamWindow(td512ctx *ctx, const uint32_t nWindowVals);
+int32_t td512LoadDictionary(td512ctx *ctx, const unsigned char *dictVals, const uint32_t nDictVals);
+int32_t td512_ctx(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues);
+int32_t td512d_ctx(td512ctx *ctx, const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed);
+int32_t td4k(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues);
+int32_t td4kd(const unsigned char *inVals, unsigned char *outVals, uint32_t *totalBytesProcessed);
 
 #endif /* td512_h */
@@ -583,6 +583,24 @@ int32_t td5d(const unsigned char *inVals, unsigned char *outVals, const uint32_t
     }
 } // end td5d
 
+uint32_t td5Bits(const unsigned char *inVals, const uint32_t nOriginalValues)
+{
+    // number of bits output by td5 for the encoding of 1 to 5 values at inVals
+    const uint32_t firstByte=inVals[0];
+    static const uint32_t textBits[6]={0, 5, 10, 14, 18, 23};
+    static const uint32_t otherBits[6]={0, 5, 12, 14, 20, 21};
+    if ((firstByte & 3) == 1 && nOriginalValues > 1)
+        return 10; // single unique
+    if ((firstByte & 3) == 3 && nOriginalValues > 1)
+    {
+        // text chars, with an 8-bit fifth value when bit 2 of the third byte is 0
+        if (nOriginalValues == 5 && (inVals[2] & 4) == 0)
+            return 27;
+        return textBits[nOriginalValues];
+    }
+    return otherBits[nOriginalValues];
+} // end td5Bits
+
 static uint32_t textNBitsTable[MAX_PREDEFINED_FREQUENCY_CHAR_COUNT]={
     3, 3, 4, 4,
     5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
@@ -679,7 +697,311 @@ static inline uint32_t setAdaptiveChars(const unsigned char *val256, unsigned ch
     }
 } // end setAdaptiveChars
 
-int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes)
+// bigram text mode: one code for each of the 23 characters of a text table, each of 16 frequent bigrams and an escape
+#define BIGRAM_TEXT_SYMBOLS 40
+#define BIGRAM_TEXT_FIRST_BIGRAM 23 // symbol of the first bigram
+#define BIGRAM_TEXT_START_VALUES 32 // values checked for bigrams before bigram text mode is sized
+#define BIGRAM_TEXT_MIN_STARTS 2 // bigrams that must start in those values
+#define BIGRAM_TEXT_ESCAPE 39 // symbol for a value not in the table, followed by the 7- or 8-bit value
+// a bigram encoding table holds for each value a mask of the bigrams with the value first in bits 0-15, a mask of those
+// with it second in bits 16-31 and its code as a character in bits 32-63, followed by the code of each bigram indexed by bigramBitIx
+#define BIGRAM_CODES 256
+#define BIGRAM_ENCODING_SIZE (256+32)
+
+// text tables registered with td64RegisterTextTable: characters, encoding indexes and character bits as for the predefined tables
+static uint32_t trainedTextChars[TD64_MAX_TEXT_TABLES][TD64_TEXT_TABLE_CHARS];
+static uint32_t trainedTextEncoding[TD64_MAX_TEXT_TABLES][256];
+static uint32_t trainedTextCharBits[TD64_MAX_TEXT_TABLES][256];
+static uint32_t trainedTextTableSet[TD64_MAX_TEXT_TABLES];
+// bigrams registered with td64RegisterTextBigrams for a registered table
+static uint64_t trainedBigramEncoding[TD64_MAX_TEXT_TABLES][BIGRAM_ENCODING_SIZE];
+static uint32_t trainedBigramSymbols[TD64_MAX_TEXT_TABLES][BIGRAM_TEXT_SYMBOLS];
+static uint32_t trainedBigramsSet[TD64_MAX_TEXT_TABLES];
+
+int32_t td64RegisterTextTable(const uint32_t tableId, const unsigned char *textChars)
+{
+    // register TD64_TEXT_TABLE_CHARS distinct characters, most frequent first, such as from td64TrainTextTable
+    // the same table must be registered with the same id to decode
+    uint32_t i;
+    if (tableId >= TD64_MAX_TEXT_TABLES)
+        return -14;
+    for (i=0; i<256; i++)
+    {
+        trainedTextEncoding[tableId][i] = 99;
+        trainedTextCharBits[tableId][i] = 0;
+    }
+    for (i=0; i<TD64_TEXT_TABLE_CHARS; i++)
+    {
+        if (trainedTextCharBits[tableId][textChars[i]])
+        {
+            trainedTextTableSet[tableId] = 0;
+            return -15; // characters must be distinct
+        }
+        trainedTextChars[tableId][i] = textChars[i];
+        trainedTextEncoding[tableId][textChars[i]] = i;
+        trainedTextCharBits[tableId][textChars[i]] = 1;
+    }
+    trainedTextTableSet[tableId] = 1;
+    trainedBigramsSet[tableId] = 0; // bigrams are registered again for new characters
+    return 0;
+} // end td64RegisterTextTable
+
+int32_t td64CheckTextTable(const int32_t tableId)
+{
+    // tableId for td64_table and td512_table: a registered table, or -1 for the predefined tables
+    if (tableId < -1 || tableId >= TD64_MAX_TEXT_TABLES || (tableId >= 0 && trainedTextTableSet[tableId] == 0))
+        return -14;
+    return 0;
+} // end td64CheckTextTable
+
+const uint32_t *td64TextCharBits(const int32_t tableId)
+{
+    // characters counted when deciding on text mode with tableId, or with the predefined tables when tableId is -1
+    if (tableId < 0)
+        return predefinedBitTextChars;
+    return trainedTextCharBits[tableId];
+} // end td64TextCharBits
+
+// bigram text mode: 16 frequent bigrams of English text for the predefined standard text characters
+static const unsigned char predefinedBigrams[TD64_TEXT_BIGRAMS*2]={
+    't','h', 'o','r', 'o','n', 'e','r', 'h','e', 'i','n', 'r','e', 't','i',
+    'e','n', 'a','n', 'a','t', 'o','f', 't','e', 'e','d', 'n','d', 'e','s'
+};
+// 2 bits for the first character, 5 bits for the next 10, 6 bits for the next 8 and the first 5 bigrams,
+// 7 bits for the last 4 characters and the next 9 bigrams, 8 bits for the last 2 bigrams and 3 bits
+// for the escape; codes are output low bit first
+static const uint32_t bigramTextNBits[BIGRAM_TEXT_SYMBOLS]={
+    2,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7,
+    6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7, 7,
+    8, 8,
+    3
+};
+static const uint32_t bigramTextBitVal[BIGRAM_TEXT_SYMBOLS]={
+    0x00,
+    0x06, 0x16, 0x0e, 0x1e, 0x01, 0x11, 0x09, 0x19, 0x05, 0x15,
+    0x0d, 0x2d, 0x1d, 0x3d, 0x03, 0x23, 0x13, 0x33,
+    0x27, 0x67, 0x17, 0x57,
+    0x0b, 0x2b, 0x1b, 0x3b, 0x07,
+    0x37, 0x77, 0x0f, 0x4f, 0x2f, 0x6f, 0x1f, 0x5f, 0x3f,
+    0x7f, 0xff,
+    0x02
+};
+static uint32_t bigramTextDecode[256]; // symbol for the next 8 bits
+static uint64_t predefinedBigramEncoding[BIGRAM_ENCODING_SIZE];
+static uint32_t predefinedBigramSymbols[BIGRAM_TEXT_SYMBOLS]; // output values in bits 0-15, count in bits 16-17
+static unsigned char bigramPosIx[64]; // position of a single bit from its bigramPos index
+static uint32_t initBigramText; // called once to init
+
+static inline uint32_t bigramBitIx(const uint32_t bigramBit)
+{
+    // distinct index from 0 to 31 for each single bit, 0 also for no bits
+    return (bigramBit * 0x077CB531u) >> 27;
+} // end bigramBitIx
+
+static inline uint32_t bigramPos(const uint64_t bigrams)
+{
+    // position of the lowest bit set in bigrams
+    return bigramPosIx[((bigrams & (0-bigrams)) * 0x03f79d71b4cb0a89llu) >> 58];
+} // end bigramPos
+
+static inline uint32_t bigramCode(const uint32_t symbol)
+{
+    // code of a symbol in bits 0-15 and its number of bits in bits 16-23
+    return bigramTextBitVal[symbol] | (bigramTextNBits[symbol] << 16);
+} // end bigramCode
+
+static void setBigramSymbols(const uint32_t *textChars, const unsigned char *bigrams, uint64_t *bigramEncoding, uint32_t *symbols)
+{
+    // the values each symbol decodes to and the encoding table of the characters and bigrams
+    uint32_t i;
+    memset(bigramEncoding, 0, BIGRAM_ENCODING_SIZE * sizeof(uint64_t));
+    for (i=0; i<256; i++)
+    {
+        // escape followed by the 8-bit value, with bit 24 set to output 7 bits for 7-bit values
+        bigramEncoding[i] = (uint64_t)((bigramCode(BIGRAM_TEXT_ESCAPE) + (8 << 16)) | (i << bigramTextNBits[BIGRAM_TEXT_ESCAPE]) | (1 << 24)) << 32;
+    }
+    for (i=0; i<TD64_TEXT_TABLE_CHARS; i++)
+    {
+        symbols[i] = textChars[i] | (1 << 16);
+        bigramEncoding[textChars[i]] = (uint64_t)bigramCode(i) << 32;
+    }
+    for (i=0; i<TD64_TEXT_BIGRAMS; i++)
+    {
+        symbols[BIGRAM_TEXT_FIRST_BIGRAM+i] = bigrams[i*2] | ((uint32_t)bigrams[i*2+1] << 8) | (2 << 16);
+        bigramEncoding[bigrams[i*2]] |= 1u << i;
+        bigramEncoding[bigrams[i*2+1]] |= 1u << (i+16);
+        bigramEncoding[BIGRAM_CODES+bigramBitIx(1 << i)] = bigramCode(BIGRAM_TEXT_FIRST_BIGRAM+i);
+    }
+} // end setBigramSymbols
+
+static void initBigramTextMode(void)
+{
+    uint32_t symbol;
+    uint32_t i;
+    for (symbol=0; symbol<BIGRAM_TEXT_SYMBOLS; symbol++)
+    {
+        // every 8-bit value whose low bits are the code of symbol
+        for (i=0; i < 256u >> bigramTextNBits[symbol]; i++)
+            bigramTextDecode[bigramTextBitVal[symbol] | (i << bigramTextNBits[symbol])] = symbol;
+    }
+    for (i=0; i<64; i++)
+        bigramPosIx[((1llu << i) * 0x03f79d71b4cb0a89llu) >> 58] = (unsigned char)i;
+    setBigramSymbols(extendedTextChars, predefinedBigrams, predefinedBigramEncoding, predefinedBigramSymbols);
+    initBigramText = 1;
+} // end initBigramTextMode
+
+int32_t td64RegisterTextBigrams(const uint32_t tableId, const unsigned char *bigrams)
+{
+    // register TD64_TEXT_BIGRAMS distinct pairs of values, most frequent first, such as from td64TrainTextBigrams,
+    // for the table registered with td64RegisterTextTable
+    // the same bigrams must be registered with the same id to decode
+    uint32_t i;
+    uint32_t j;
+    if (tableId >= TD64_MAX_TEXT_TABLES || trainedTextTableSet[tableId] == 0)
+        return -14;
+    for (i=1; i<TD64_TEXT_BIGRAMS; i++)
+    {
+        for (j=0; j<i; j++)
+        {
+            if (bigrams[i*2] == bigrams[j*2] && bigrams[i*2+1] == bigrams[j*2+1])
+                return -15; // bigrams must be distinct
+        }
+    }
+    if (initBigramText == 0)
+        initBigramTextMode();
+    setBigramSymbols(trainedTextChars[tableId], bigrams, trainedBigramEncoding[tableId], trainedBigramSymbols[tableId]);
+    trainedBigramsSet[tableId] = 1;
+    return 0;
+} // end td64RegisterTextBigrams
+
+static inline uint64_t chooseBigrams(const uint64_t starts)
+{
+    // choose bigrams as encoding one value at a time from the first would: in each run of consecutive starts,
+    // the first start and every second one after it
+    // adding the first bit of each run that starts at an even position clears only those runs
+    const uint64_t evenBits=0x5555555555555555llu;
+    const uint64_t runStarts=starts & ~(starts << 1);
+    const uint64_t evenRuns=starts & ~(starts + (runStarts & evenBits));
+    return (evenRuns & evenBits) | (starts & ~evenRuns & ~evenBits);
+} // end chooseBigrams
+
+static uint64_t bigramChunkCodes(const unsigned char *inVals, const uint32_t chunkPos, const uint32_t nChunkVals, const uint32_t nValues, const uint64_t *bigramEncoding, uint32_t *codes)
+{
+    // code of each of up to 64 values from chunkPos: the bigram code for the first value of a chosen bigram,
+    // 0 for its second value, else the character or escape code
+    // returns the chosen bigrams, bit i for the bigram that starts at value chunkPos+i
+    uint32_t masks[65];
+    uint64_t starts=0;
+    uint64_t bigrams;
+    uint64_t chosen;
+    uint32_t i;
+    codes[0] = (uint32_t)(bigramEncoding[inVals[chunkPos]] >> 32);
+    masks[0] = (uint32_t)bigramEncoding[inVals[chunkPos]];
+    for (i=1; i<nChunkVals; i++)
+    {
+        const uint64_t valEncoding=bigramEncoding[inVals[chunkPos+i]];
+        codes[i] = (uint32_t)(valEncoding >> 32);
+        masks[i] = (uint32_t)valEncoding;
+        // bigrams are distinct, so at most one bit is set in the masks of both values
+        starts |= (uint64_t)((masks[i-1] & (masks[i] >> 16)) != 0) << (i-1);
+    }
+    // a bigram may start at the last value when a value follows
+    masks[nChunkVals] = chunkPos+nChunkVals < nValues ? (uint32_t)bigramEncoding[inVals[chunkPos+nChunkVals]] : 0;
+    starts |= (uint64_t)((masks[nChunkVals-1] & (masks[nChunkVals] >> 16)) != 0) << (nChunkVals-1);
+    bigrams = chosen = chooseBigrams(starts);
+    while (chosen)
+    {
+        const uint32_t pos=bigramPos(chosen);
+        codes[pos] = (uint32_t)bigramEncoding[BIGRAM_CODES+bigramBitIx(masks[pos] & (masks[pos+1] >> 16))];
+        codes[pos+1] = 0;
+        chosen &= chosen - 1;
+    }
+    return bigrams;
+} // end bigramChunkCodes
+
+static uint32_t bigramTextSaves(const unsigned char *inVals, const uint32_t nValues, const uint32_t *textEncodingArray, const uint64_t *bigramEncoding, uint32_t *codes, uint64_t *bigrams)
+{
+    // whether bigram text mode outputs fewer bits than text mode with the same characters for up to the first 64 values
+    // escaped values are counted as 8 bits in both
+    // when it does, codes and bigrams are those of bigramChunkCodes for the first 64 values
+    const uint32_t nCheckVals=nValues < 64 ? nValues : 64;
+    const uint32_t nStartVals=nValues < BIGRAM_TEXT_START_VALUES ? nValues : BIGRAM_TEXT_START_VALUES;
+    uint32_t mask=(uint32_t)bigramEncoding[inVals[0]];
+    uint32_t nStarts=0;
+    uint32_t textBits=0;
+    uint32_t bigramBits=0;
+    uint32_t i;
+    // first a count of the bigrams that start in the first values: with few of them, the codes are not generated
+    for (i=1; i<nStartVals; i++)
+    {
+        const uint32_t nextMask=(uint32_t)bigramEncoding[inVals[i]];
+        nStarts += (mask & (nextMask >> 16)) != 0;
+        mask = nextMask;
+    }
+    if (nStarts < BIGRAM_TEXT_MIN_STARTS)
+        return 0;
+    *bigrams = bigramChunkCodes(inVals, 0, nCheckVals, nValues, bigramEncoding, codes);
+    for (i=0; i<nCheckVals; i++)
+    {
+        const uint32_t eVal=textEncodingArray[inVals[i]];
+        textBits += eVal < MAX_PREDEFINED_FREQUENCY_CHAR_COUNT ? textNBitsTable[eVal] : 3+8;
+        bigramBits += (codes[i] >> 16) & 0xff;
+    }
+    return bigramBits < textBits;
+} // end bigramTextSaves
+
+static int32_t encodeBigramTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint64_t *bigramEncoding, const uint32_t *firstCodes, const uint64_t firstBigrams, const int32_t tableId, const uint32_t highBitclear, const uint32_t maxBytes, const uint32_t sizeOnly)
+{
+    // as adaptiveTextMode with one code for each pair of values that is a bigram
+    // bigrams are chosen for 64 values at a time, after which the code of each value does not depend on the previous one
+    // the codes of the first 64 values are those already generated by bigramTextSaves
+    // outVals[0] is TD64_BIGRAM_TEXT_MODE, or TD64_TRAINED_BIGRAM_MODE followed by the table id
+    uint32_t chunkPos=0;
+    uint32_t nextOutIx=1;
+    uint32_t nextOutBit=0;
+    uint64_t outBits=0; // store 64 bits before writing
+    
+    if (tableId >= 0)
+    {
+        outVals[0] = TD64_TRAINED_BIGRAM_MODE;
+        outVals[1] = (unsigned char)tableId;
+        nextOutIx = 2;
+    }
+    else
+        outVals[0] = TD64_BIGRAM_TEXT_MODE;
+    if (highBitclear)
+        outVals[0] |= 128; // 7-bit escaped values
+    while (chunkPos < nValues)
+    {
+        const uint32_t nChunkVals=nValues-chunkPos < 64 ? nValues-chunkPos : 64;
+        uint32_t chunkCodes[65];
+        const uint32_t *codes=firstCodes;
+        uint64_t bigrams=firstBigrams;
+        uint32_t i;
+        if (chunkPos)
+        {
+            bigrams = bigramChunkCodes(inVals, chunkPos, nChunkVals, nValues, bigramEncoding, chunkCodes);
+            codes = chunkCodes;
+        }
+        for (i=0; i<nChunkVals; i++)
+        {
+            const uint32_t code=codes[i];
+            if (nextOutIx > maxBytes && (code >> 24))
+                return 0; // requested compression not met at an escaped value
+            thisOutIx2Sized(outVals, ((code >> 16) & 0xff) - ((code >> 24) & highBitclear), code & 0xffff, &nextOutIx, &nextOutBit, &outBits, sizeOnly);
+        }
+        // a bigram chosen at the last value includes the first value of the next 64
+        chunkPos += nChunkVals + (uint32_t)(bigrams >> 63);
+    }
+    esmOutputRemainderSized(outVals, &nextOutIx, &nextOutBit, &outBits, sizeOnly);
+    return nextOutIx * 8;
+} // end encodeBigramTextMode
+
+static inline int32_t adaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes, const int32_t tableId, const uint32_t sizeOnly)
 {
     // Use these frequency-related bit encodings:
     // 101       value not in 23 text values, followed by 8-bit value
@@ -696,11 +1018,33 @@ int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVa
     uint32_t eVal;
     const uint32_t *textEncodingArray=extendedTextEncoding;
     const uint32_t output7or8=highBitclear ? 7 : 8;
+    const uint64_t *bigramEncoding=NULL; // bigrams for the standard or a registered table
+    uint32_t firstCodes[65]; // bigram text mode codes of the first 64 values
+    uint64_t firstBigrams=0;
     
-    if (predefinedTextCharCnt)
+    if (tableId >= 0)
+    {
+        // registered table: its id follows the info byte
+        textEncodingArray = trainedTextEncoding[tableId];
+        outVals[0] = TD64_TRAINED_TEXT_MODE;
+        outVals[1] = (unsigned char)tableId;
+        nextOutIx = 2;
+        if (trainedBigramsSet[tableId])
+            bigramEncoding = trainedBigramEncoding[tableId];
+    }
+    else if (predefinedTextCharCnt || setAdaptiveChars(val256, outVals, nValues, &textEncodingArray) == 0)
+    {
         outVals[0] = 0x7; // default to standard text mode if predefined text char count is high enough
-    else
-        setAdaptiveChars(val256, outVals, nValues, &textEncodingArray);
+        bigramEncoding = predefinedBigramEncoding;
+    }
+    if (bigramEncoding != NULL)
+    {
+        // one code for each bigram when that outputs fewer bits
+        if (initBigramText == 0)
+            initBigramTextMode();
+        if (bigramTextSaves(inVals, nValues, textEncodingArray, bigramEncoding, firstCodes, &firstBigrams))
+            return encodeBigramTextMode(inVals, outVals, nValues, bigramEncoding, firstCodes, firstBigrams, tableId, highBitclear, maxBytes, sizeOnly);
+    }
     if (highBitclear)
         outVals[0] |= 128; // set high bit of info byte to indicate 7-bit values
     while (pInVal < pLastInValPlusOne)
@@ -709,15 +1053,15 @@ int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVa
         if (eVal < MAX_PREDEFINED_FREQUENCY_CHAR_COUNT)
         {
             // encode predefined chars and adaptive chars
-            thisOutIx2(outVals, textNBitsTable[eVal], textBitValTable[eVal], &nextOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outVals, textNBitsTable[eVal], textBitValTable[eVal], &nextOutIx, &nextOutBit, &outBits, sizeOnly);
         }
         else
         {
             // output char not predefined or adaptive
             if (nextOutIx > maxBytes)
                 return 0; // requested compression not met
-            thisOutIx2(outVals, 3, 0x5, &nextOutIx, &nextOutBit, &outBits);
-            thisOutIx2(outVals, output7or8, inVal, &nextOutIx, &nextOutBit, &outBits); // output 7 bits if high bit clear, else 8
+            thisOutIx2Sized(outVals, 3, 0x5, &nextOutIx, &nextOutBit, &outBits, sizeOnly);
+            thisOutIx2Sized(outVals, output7or8, inVal, &nextOutIx, &nextOutBit, &outBits, sizeOnly); // output 7 bits if high bit clear, else 8
 #ifdef TD64_TEST_MODE
             if (textEncodingArray == extendedTextEncoding)
                 g_td64Text8bitCount++;
@@ -726,13 +1070,28 @@ int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVa
 #endif
         }
     }
-    esmOutputRemainder(outVals, &nextOutIx, &nextOutBit, &outBits);
+    esmOutputRemainderSized(outVals, &nextOutIx, &nextOutBit, &outBits, sizeOnly);
     return nextOutIx * 8;
+} // end adaptiveTextMode
+
+int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes, const int32_t tableId)
+{
+    // text mode with the bits of each value written to outVals, with registered table tableId or -1 for the predefined tables
+    // returns 0 at an escaped value once more than maxBytes are output
+    return adaptiveTextMode(inVals, outVals, nValues, val256, predefinedTextCharCnt, highBitclear, maxBytes, tableId, 0);
 } // end encodeAdaptiveTextMode
 
-int32_t encodeSingleValueMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, int32_t singleValue, const uint32_t compressNSV)
+int32_t adaptiveTextModeBits(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes, const int32_t tableId)
+{
+    // bits output by encodeAdaptiveTextMode, counted without output of the values: outVals gets only the info bytes
+    // and adaptive characters, and the same 0 is returned at an escaped value once more than maxBytes would be output
+    return adaptiveTextMode(inVals, outVals, nValues, val256, predefinedTextCharCnt, highBitclear, maxBytes, tableId, 1);
+} // end adaptiveTextModeBits
+
+int32_t encodeSingleValueMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, int32_t singleValue, const uint32_t compressNSV, const uint32_t sizeOnly)
 {
     // generate control bit 1 if single value, otherwise 0 plus 8-bit value
+    // when sizeOnly is set, return the bits without output of the compressed non-single values
     const unsigned char *pInVal=inVals;
     const unsigned char *pLastInValPlusOne=inVals+nValues;
     uint32_t inVal;
@@ -821,7 +1180,8 @@ int32_t encodeSingleValueMode(const unsigned char *inVals, unsigned char *outVal
         uint32_t nNSV=nextOutVal-firstNonSingle+1;
         if (nNSV >= MIN_STRING_MODE_EXTENDED_VALUES)
         {
-            unsigned char outTemp[64];
+            unsigned char outTemp[MAX_TD64_BYTES+3]; // room for the nNSV+3 bytes that string mode may output
+            unsigned char nsvVals[MAX_TD64_BYTES+1];
             int32_t retBits;
             uint32_t nValuesOut;
 #ifdef TD64_TEST_MODE
@@ -829,7 +1189,10 @@ int32_t encodeSingleValueMode(const unsigned char *inVals, unsigned char *outVal
             g_td64CompressNSVblocks++;
             g_td64nNSVcnt += nNSV;
 #endif
-            retBits = encodeExtendedStringMode(outVals+firstNonSingle, outTemp, nNSV, &nValuesOut);
+            // string mode includes one value past the non-single values: set it to 0 rather than reading past them
+            memcpy(nsvVals, outVals+firstNonSingle, nNSV-1);
+            nsvVals[nNSV-1] = 0;
+            retBits = encodeExtendedStringModeMax(nsvVals, outTemp, nNSV, &nValuesOut, nNSV+3, sizeOnly);
             if (retBits < 0)
                 return -28;
             if (retBits > (nNSV-2)*8 || retBits == 0)
@@ -849,7 +1212,8 @@ int32_t encodeSingleValueMode(const unsigned char *inVals, unsigned char *outVal
                 if (retBits & 7)
                     nBytes++;
                 // don't keep first byte that is 0x7f for extended string mode
-                memcpy(outVals+firstNonSingle+1, outTemp+1, nBytes-1);
+                if (!sizeOnly)
+                    memcpy(outVals+firstNonSingle+1, outTemp+1, nBytes-1);
 #ifdef TD64_TEST_MODE
                 g_td64CompressNonSingleValues += retBits-8;
 #endif
@@ -919,8 +1283,9 @@ int32_t encode7bits(const unsigned char *inVals, unsigned char *outVals, const u
 
 #define STRING_LIMIT 9
 
-int32_t encodeStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t nUniquesIn, const uint32_t *uniqueOccurrence, const uint32_t highBitClear, const uint32_t maxBits)
+int32_t encodeStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t nUniquesIn, const uint32_t *uniqueOccurrence, const uint32_t highBitClear, const uint32_t maxBits, const uint32_t sizeOnly)
 {
+    // when sizeOnly is set, return the bits without output of the encoding
     uint32_t twoValsPos[256]; // set to position+1 of first occurrence of value
     uint32_t nUniques; // first value is always a unique
     // if all inputs have high bit 0, compress the input values
@@ -983,7 +1348,10 @@ int32_t encodeStringMode(const unsigned char *inVals, unsigned char *outVals, co
             if (++nextOutBit == 64)
             {
                 // output outBits and init for next output
-                esmOutputOutBits(outVals, &nextOutIx, &outBits);
+                if (sizeOnly)
+                    nextOutIx += 8;
+                else
+                    esmOutputOutBits(outVals, &nextOutIx, &outBits);
                 outBits = 0;
                 nextOutBit = 0;
             }
@@ -998,7 +1366,7 @@ int32_t encodeStringMode(const unsigned char *inVals, unsigned char *outVals, co
             {
                 // pos of unique plus one and next input value match
                 // output repeated value: 01 plus unique
-                thisOutIx2(outVals, 2+encodingBits[nUniques-1], 1|(uoInVal<<2), &nextOutIx, &nextOutBit, &outBits);
+                thisOutIx2Sized(outVals, 2+encodingBits[nUniques-1], 1|(uoInVal<<2), &nextOutIx, &nextOutBit, &outBits, sizeOnly);
                 continue;
             }
             // look for continuation of matching characters
@@ -1015,9 +1383,9 @@ int32_t encodeStringMode(const unsigned char *inVals, unsigned char *outVals, co
                 tvPos++;
             }
             // output 11 plus 3 more bits for string length 2 to 9
-            thisOutIx2(outVals, 5, 3 | ((strCount-2)<<2), &nextOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outVals, 5, 3 | ((strCount-2)<<2), &nextOutIx, &nextOutBit, &outBits, sizeOnly);
             // output the unique that started this string, which gives its position
-            thisOutIx2(outVals, encodingBits[nUniques-1], uoInVal, &nextOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outVals, encodingBits[nUniques-1], uoInVal, &nextOutIx, &nextOutBit, &outBits, sizeOnly);
             inPos += strCount - 1;
             nextInVal = inVals[inPos]; // new next val after string
         }
@@ -1025,145 +1393,119 @@ int32_t encodeStringMode(const unsigned char *inVals, unsigned char *outVals, co
         {
             // this pair doesn't match the one for first occurrence of this unique
             // repeated value: 01
-            thisOutIx2(outVals, 2+encodingBits[nUniques-1], 1|(uoInVal<<2), &nextOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outVals, 2+encodingBits[nUniques-1], 1|(uoInVal<<2), &nextOutIx, &nextOutBit, &outBits, sizeOnly);
         }
     }
-    esmOutputRemainder(outVals, &nextOutIx, &nextOutBit, &outBits);
+    esmOutputRemainderSized(outVals, &nextOutIx, &nextOutBit, &outBits, sizeOnly);
     // output final bits
     if (inPos < nValues)
     {
-        outVals[nextOutIx++] = inVals[lastPos]; // output last input byte
+        if (!sizeOnly)
+            outVals[nextOutIx] = inVals[lastPos]; // output last input byte
+        nextOutIx++;
     }
     if (nextOutIx*8 <= maxBits)
         return (int32_t)nextOutIx * 8;
     return 0; // not compressible
 } // end encodeStringMode
 
-int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
-// td64: Compress nValues bytes. Return 0 if not compressible (no output bytes),
-//    negative value if error; otherwise, number of bits written to outVals.
-//    Management of whether compressible and number of input values must be maintained
-//    by caller. Decdode requires number of input values and only accepts compressed data.
-// Arguments:
-//   inVals   input byte values
-//   outVals  output byte values if compressed, max of inVals bytes
-//   nValues  number of input byte values
-// Returns number of bits compressed, 0 if not compressed, or negative value if error
+int32_t encodeSharedUniquesMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t *sharedOccurrence, const uint32_t nSharedUniques, uint32_t *uniquesUsed)
 {
-    if (nValues <= 5)
-        return td5(inVals, outVals, nValues);
-    
-    if (nValues > MAX_TD64_BYTES)
-        return -1; // only values 1 to 64 supported
+    // fixed bit coding against a unique table that td512 outputs once for all of its td64 blocks
+    // the uniques are not output here: only the mode byte followed by the index of each value
+    // sharedOccurrence holds the position in the shared table of every value in inVals
+    // uniquesUsed returns a bit for each shared unique referenced by this block so that the
+    //    caller can decide whether td64 with its own uniques would be smaller
+    const unsigned char *pInVal=inVals;
+    const unsigned char *pLastInValPlusOne=inVals+nValues;
+    uint32_t nextOutIx=1;
+    uint32_t nextOutBit=0;
+    uint64_t outBits=0; // store 64 bits before writing
+    uint32_t usedBits=0;
+    const uint32_t nBits=nSharedUniques > 1 ? encodingBits[nSharedUniques-1] : 0;
     
-    uint32_t highBitCheck=0;
-    uint32_t predefinedTextCharCnt=0; // count of text chars encountered
-    uint32_t uniqueOccurrence[256]; // order of occurrence of uniques
-    uint32_t nUniqueVals=0; // count of unique vals encountered
-    uint8_t val256[256]={0}; // init characters found to 0
-    const uint32_t uniqueLimit=uniqueLimits25[nValues]; // if exceeded, cannot use fixed bit coding
-
-    // process enough input vals to eliminate most random data and to check for text mode
-    // for fixed bit coding find and output the uniques starting at outVal[1]
-    //    and saving the unique occurrence value to be used when values are output
-    // for 7 bit mode OR every value
-    // for text mode count number of predfined text characters
-    // for single value mode accumulate frequency counts
-    const uint32_t nValsInitLoop=nValues<24 ? nValues/2 : nValues*7/16; // 1-23 use 1/2 nValues, 24+ use 7/16 nValues; fewer values means faster execution but possibly lower compression
-    uint32_t inPos=0;
-    while (inPos < nValsInitLoop)
+    if (nSharedUniques == 0 || nSharedUniques > MAX_UNIQUES)
+        return -10;
+    outVals[0] = TD64_SHARED_UNIQUES_MODE;
+    if (nBits == 0)
     {
-        const uint32_t inVal=inVals[inPos++];
-        predefinedTextCharCnt += predefinedBitTextChars[inVal]; // count text chars for text char mode
-        if (val256[inVal]++ == 0)
-        {
-            // first occurrence of value, for fixed bit coding:
-            uniqueOccurrence[inVal] = nUniqueVals; // save occurrence count for this unique
-            outVals[++nUniqueVals] = (unsigned char)inVal; // store unique starting at second byte
-            highBitCheck |= inVal; // keep watch on high bit of unique values
-        }
+        // single unique: nothing follows the mode byte
+        *uniquesUsed = 1;
+        return 8;
     }
-    if (nUniqueVals > nValsInitLoop - nValsInitLoop/8 - 1 && (highBitCheck & 0x80))
+    while (pInVal < pLastInValPlusOne)
     {
-        // unique values exceed usual count to be compressed and high bit across tested values is not 0
-        outVals[0] = 0; // indicate random data failure in first check
-        return 0;
+        const uint32_t uniqueIx=sharedOccurrence[*(pInVal++)];
+        usedBits |= 1 << uniqueIx;
+        thisOutIx2(outVals, nBits, uniqueIx, &nextOutIx, &nextOutBit, &outBits);
     }
-    if (nUniqueVals > uniqueLimit/2 && predefinedTextCharCnt > nValsInitLoop/2)
-    {
-        // encode in text mode if at least 11% compression expected
+    esmOutputRemainder(outVals, &nextOutIx, &nextOutBit, &outBits);
+    *uniquesUsed = usedBits;
+    return (int32_t)nextOutIx * 8;
+} // end encodeSharedUniquesMode
+
+int32_t sharedUniquesModeBits(const unsigned char *inVals, const uint32_t nValues, const uint32_t *sharedOccurrence, const uint32_t nSharedUniques, uint32_t *uniquesUsed)
+{
+    // bits output by encodeSharedUniquesMode, with the same uniquesUsed, without output
+    const uint32_t nBits=nSharedUniques > 1 ? encodingBits[nSharedUniques-1] : 0;
+    uint32_t usedBits=0;
+    uint32_t i;
+    
+    if (nSharedUniques == 0 || nSharedUniques > MAX_UNIQUES)
+        return -10;
+    for (i=0; i<nValues; i++)
+        usedBits |= 1 << sharedOccurrence[inVals[i]];
+    *uniquesUsed = usedBits;
+    return (int32_t)(1 + (nValues*nBits+7)/8) * 8;
+} // end sharedUniquesModeBits
+
+static inline int32_t td64TextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t useExtendedTextMode, const uint32_t highBitClear, const uint32_t nUniqueVals, const int32_t tableId, const uint32_t sizeOnly)
+{
+    // encode in text mode, restoring the uniques saved in outVals if text mode fails
+    // when sizeOnly is set, return the bits without output of the encoding
 #ifdef TD64_TEST_MODE
-        uint32_t save8bitCount=g_td64Text8bitCount;
-        uint32_t saveAdaptive8bitCount=g_td64AdaptiveText8bitCount;
+    uint32_t save8bitCount=g_td64Text8bitCount;
+    uint32_t saveAdaptive8bitCount=g_td64AdaptiveText8bitCount;
 #endif
-        const uint32_t useExtendedTextMode=predefinedTextCharCnt >= nValsInitLoop*7/8; // use extended text mode rather than adaptive text mode
-        uint32_t highBitClear=0;
-        if ((highBitCheck & 0x80) == 0)
-        {
-            // original values encoded with 7 bits if high bit is clear for all else 8 bits
-            uint32_t inPos2=inPos;
-            while (inPos2 < nValues)
-                highBitCheck |= inVals[inPos2++]; // check for remaining values with high bit clear
-            if ((highBitCheck & 0x80) == 0)
-                highBitClear = 1;
-        }
-        // save uniques in outVals to recover on failure
-        unsigned char saveUniques[MAX_TD64_BYTES];
-        memcpy(saveUniques, outVals+1, nUniqueVals);
-        int32_t retBits=encodeAdaptiveTextMode(inVals, outVals, nValues, val256, useExtendedTextMode, highBitClear, nValues-nValues/8);
-        if (retBits != 0)
-            return retBits;
-        memcpy(outVals+1, saveUniques, nUniqueVals);
+    // save uniques in outVals to recover on failure
+    unsigned char saveUniques[MAX_TD64_BYTES];
+    memcpy(saveUniques, outVals+1, nUniqueVals);
+    int32_t retBits=adaptiveTextMode(inVals, outVals, nValues, val256, useExtendedTextMode, highBitClear, nValues-nValues/8, tableId, sizeOnly);
+    if (retBits != 0)
+        return retBits;
+    memcpy(outVals+1, saveUniques, nUniqueVals);
 #ifdef TD64_TEST_MODE
-        g_td64Text8bitCount = save8bitCount; // reset count before failure
-        g_td64AdaptiveText8bitCount = saveAdaptive8bitCount; // reset
-        g_td64FailedTextMode++;
+    g_td64Text8bitCount = save8bitCount; // reset count before failure
+    g_td64AdaptiveText8bitCount = saveAdaptive8bitCount; // reset
+    g_td64FailedTextMode++;
 #endif
-    }
-    // continue fixed bit loop with check for single value
-    // perform this even when uniqueLimit is exceeded to do single value mode and string mode
-    const uint32_t minRepeatsSingleValueMode=nValues<16 ? nValues/2 : nValues/4+2;
-    int32_t singleValue=-1; // set to value if min repeats reached
-    while (inPos < nValues)
-    {
-        // will always complete this loop unless single value count reached
-        const uint32_t inVal=inVals[inPos++];
-        if (val256[inVal]++ == 0)
-        {
-         // first occurrence of value, for fixed bit coding:
-            uniqueOccurrence[inVal] = nUniqueVals; // save occurrence count for this unique
-            outVals[++nUniqueVals] = (unsigned char)inVal; // store unique starting at second byte
-            highBitCheck |= inVal;
-        }
-        else if (val256[inVal] >= minRepeatsSingleValueMode)
-        {
-            singleValue = (int32_t)inVal;
-            break; // continue loop without further checking
-        }
-    }
-    if (singleValue >= 0 && nUniqueVals > uniqueLimit)
-    {
-        // early opportunity for single value mode
-        // single value mode is fast and set to get minimum 12% compression for 64 values
-        // single value mode is not limited by MAX_STRING_MODE_UNIQUES
-        const uint32_t compressNSV=0; // don't compress non-single values when unique limit exceeded
-        return encodeSingleValueMode(inVals, outVals, nValues, singleValue, compressNSV);
-    }
-    if (nUniqueVals <= uniqueLimit)
-    {
-        // continue fixed bit loop with checks for high bit set and repeat counts, but without single value
-        while (inPos < nValues)
-        {
-            const uint32_t inVal=inVals[inPos++];
-            if (val256[inVal]++ == 0)
-            {
-                // first occurrence of value, for fixed bit coding:
-                uniqueOccurrence[inVal] = nUniqueVals; // save occurrence count for this unique
-                outVals[++nUniqueVals] = (unsigned char)inVal; // store unique starting at second byte
-                highBitCheck |= inVal;
-            }
-        }
-    }
+    return 0;
+} // end td64TextMode
+
+static inline int32_t fixedBitBits(const uint32_t nValues, const uint32_t nUniqueVals)
+{
+    // bits output by fixed bit coding of nValues with 1 to MAX_UNIQUES uniques
+    if (nUniqueVals == 1)
+        return 16; // indicator byte and the unique
+    if (nUniqueVals == 2)
+        return (int)nValues-1 + 21; // one bit encoding for each value + 5 indicator bits + 2 uniques
+    if (nUniqueVals <= 4)
+        return (int)(((nValues-1) * 2) + 6 + (nUniqueVals * 8)); // two bits for each value plus 6 indicator bits + 3 or 4 uniques
+    if (nUniqueVals <= 8)
+        return (int)(((nValues-1) * 3) + 5 + (nUniqueVals * 8)); // three bits for each value plus 5 indicator bits
+    return (int)(((nValues-1) * 4) + 8 + (nUniqueVals * 8)); // four bits for each value plus 8 indicator bits + 9 to 16 uniques
+} // end fixedBitBits
+
+static inline int32_t sevenBitBits(const uint32_t nValues)
+{
+    // bits output by encode7bits: 7 bytes for each 8 values, with the final values as full bytes
+    return (int32_t)(1 + nValues/8*7 + nValues%8) * 8;
+} // end sevenBitBits
+
+static inline int32_t td64EncodeModes(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t nUniqueVals, const uint32_t *uniqueOccurrence, const uint32_t highBitCheck, const int32_t singleValue, const uint32_t uniqueLimit, const uint32_t sizeOnly)
+{
+    // select and encode a mode once the uniques are in outVals starting at the second byte
+    // when sizeOnly is set, each mode returns its bits without output of the encoding
     if (nUniqueVals > uniqueLimit)
     {
         // fixed bit coding failed, try for other compression modes
@@ -1171,7 +1513,7 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
         {
             // always choose single value mode first
             const uint32_t compressNSV=0; // don't compress non-single values when unique limit exceeded
-            return encodeSingleValueMode(inVals, outVals, nValues, singleValue, compressNSV);
+            return encodeSingleValueMode(inVals, outVals, nValues, singleValue, compressNSV, sizeOnly);
         }
         const uint32_t nUniquesRandom=nValues*3/4 < MAX_STRING_MODE_UNIQUES ? nValues*3/4 : MAX_STRING_MODE_UNIQUES;
         const uint32_t checkHighBit=(highBitCheck & 0x80) == 0 && nValues >= MIN_VALUES_7_BIT_MODE;
@@ -1181,7 +1523,7 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
             {
                 // compress based on high bit clear across all values
                 // with this quantity of uniques, this mode should offer the best compression
-                return encode7bits(inVals, outVals, nValues);
+                return sizeOnly ? sevenBitBits(nValues) : encode7bits(inVals, outVals, nValues);
             }
             outVals[0] = 2; // indicate random data failure in second check
             return 0; // compression failed
@@ -1197,13 +1539,13 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
 #endif
             if (nUniqueVals >= MIN_STRING_MODE_UNIQUES)
             {
-                if ((retBits=encodeStringMode(inVals, outVals, nValues, nUniqueVals, uniqueOccurrence, checkHighBit, maxBits)) != 0)
+                if ((retBits=encodeStringMode(inVals, outVals, nValues, nUniqueVals, uniqueOccurrence, checkHighBit, maxBits, sizeOnly)) != 0)
                 return retBits;
             }
             else
             {
                 uint32_t nValuesOut;
-                if ((retBits=encodeExtendedStringMode(inVals, outVals, nValues, &nValuesOut)) < 0)
+                if ((retBits=encodeExtendedStringModeMax(inVals, outVals, nValues, &nValuesOut, nValues+3, sizeOnly)) < 0)
                     return retBits;
                 if (retBits >= maxBits)
                     return retBits;
@@ -1215,7 +1557,7 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
         if (checkHighBit)
         {
             // compress in high bit mode
-            return encode7bits(inVals, outVals, nValues);
+            return sizeOnly ? sevenBitBits(nValues) : encode7bits(inVals, outVals, nValues);
         }
         outVals[0] = 1; // indicate general failure to compress
         return 0; // unable to compress
@@ -1224,8 +1566,10 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
     {
         // favor single value over fixed 3- and 4-bit encoding
         const uint32_t compressNSV=1; // for small numbers of uniques, try to compress non-single values
-        return encodeSingleValueMode(inVals, outVals, nValues, singleValue, compressNSV);
+        return encodeSingleValueMode(inVals, outVals, nValues, singleValue, compressNSV, sizeOnly);
     }
+    if (sizeOnly && nUniqueVals > 0 && nUniqueVals <= MAX_UNIQUES)
+        return fixedBitBits(nValues, nUniqueVals);
     // process fixed bit coding inline
     uint32_t i;
     uint32_t nextOut;
@@ -1241,7 +1585,7 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
             // 1 unique so all bytes same value
                 outVals[0] = 0;
                 outVals[1] = inVals[0];
-                return 16; // return number of bits output
+                return fixedBitBits(nValues, nUniqueVals); // return number of bits output
         }
         case 2:
         {
@@ -1277,7 +1621,7 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
                 }
                 outVals[nextOut] = (unsigned char)encodingByte;
             }
-            return (int)nValues-1 + 21; // one bit encoding for each value + 5 indicator bits + 2 uniques
+            return fixedBitBits(nValues, nUniqueVals);
         }
         case 3:
         {
@@ -1316,7 +1660,7 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
                 }
                 outVals[nextOut] = (unsigned char)encodingByte; // output last partial byte
             }
-            return (int)(((nValues-1) * 2) + 6 + (nUniqueVals * 8)); // two bits for each value plus 6 indicator bits + 3 or 4 uniques
+            return fixedBitBits(nValues, nUniqueVals);
         }
         case 5:
         case 6:
@@ -1381,48 +1725,794 @@ int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t
             if (partialByte)
                 outVals[nextOut] = (unsigned char)encodingByte;
 
-            return (int)(((nValues-1) * 3) + 5 + (nUniqueVals * 8)); // three bits for each value plus 5 indicator bits
-            }
-        default: // nUniques 9 through 16
+            return fixedBitBits(nValues, nUniqueVals);
+            }
+        default: // nUniques 9 through 16
+        {
+            if (nUniqueVals > MAX_UNIQUES)
+                return -5; // unexpected program error
+            // cases 9 through 16 take 4 bits to encode
+            // skipping last 3 bits in first byte to be on even byte boundary
+            outVals[0] = (unsigned char)((nUniqueVals-1) << 1);
+            nextOut = nUniqueVals + 1; // start output past uniques
+            i = 1; // first value is implied by first unique
+            while (i + 7 < nValues)
+            {
+                encodingByte = uniqueOccurrence[inVals[i++]];
+                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
+                encodingByte = uniqueOccurrence[inVals[i++]];
+                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
+                encodingByte = uniqueOccurrence[inVals[i++]];
+                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
+                encodingByte = uniqueOccurrence[inVals[i++]];
+                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
+            }
+            while (i < nValues)
+            {
+                // 1 to 7 values remain
+                encodingByte = uniqueOccurrence[inVals[i++]];
+                if (i < nValues)
+                {
+                    outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
+                }
+                else
+                {
+                    outVals[nextOut] = (unsigned char)encodingByte;
+                    break;
+                }
+            }
+            return fixedBitBits(nValues, nUniqueVals);
+        }
+    }
+    return -6; // unexpected program error
+} // end td64EncodeModes
+
+static inline int32_t td64Encode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId, const uint32_t sizeOnly)
+{
+    if (nValues <= 5)
+        return td5(inVals, outVals, nValues);
+    
+    if (nValues > MAX_TD64_BYTES)
+        return -1; // only values 1 to 64 supported
+    
+    uint32_t highBitCheck=0;
+    uint32_t predefinedTextCharCnt=0; // count of text chars encountered
+    uint32_t uniqueOccurrence[256]; // order of occurrence of uniques
+    uint32_t nUniqueVals=0; // count of unique vals encountered
+    uint8_t val256[256]={0}; // init characters found to 0
+    const uint32_t uniqueLimit=uniqueLimits25[nValues]; // if exceeded, cannot use fixed bit coding
+
+    // process enough input vals to eliminate most random data and to check for text mode
+    // for fixed bit coding find and output the uniques starting at outVal[1]
+    //    and saving the unique occurrence value to be used when values are output
+    // for 7 bit mode OR every value
+    // for text mode count number of predfined text characters
+    // for single value mode accumulate frequency counts
+    const uint32_t nValsInitLoop=nValues<24 ? nValues/2 : nValues*7/16; // 1-23 use 1/2 nValues, 24+ use 7/16 nValues; fewer values means faster execution but possibly lower compression
+    const uint32_t *textCharBits=td64TextCharBits(tableId);
+    uint32_t inPos=0;
+    while (inPos < nValsInitLoop)
+    {
+        const uint32_t inVal=inVals[inPos++];
+        predefinedTextCharCnt += textCharBits[inVal]; // count text chars for text char mode
+        if (val256[inVal]++ == 0)
+        {
+            // first occurrence of value, for fixed bit coding:
+            uniqueOccurrence[inVal] = nUniqueVals; // save occurrence count for this unique
+            outVals[++nUniqueVals] = (unsigned char)inVal; // store unique starting at second byte
+            highBitCheck |= inVal; // keep watch on high bit of unique values
+        }
+    }
+    if (nUniqueVals > nValsInitLoop - nValsInitLoop/8 - 1 && (highBitCheck & 0x80))
+    {
+        // unique values exceed usual count to be compressed and high bit across tested values is not 0
+        outVals[0] = 0; // indicate random data failure in first check
+        return 0;
+    }
+    if (nUniqueVals > uniqueLimit/2 && predefinedTextCharCnt > nValsInitLoop/2)
+    {
+        // encode in text mode if at least 11% compression expected
+        const uint32_t useExtendedTextMode=predefinedTextCharCnt >= nValsInitLoop*7/8; // use extended text mode rather than adaptive text mode
+        uint32_t highBitClear=0;
+        if ((highBitCheck & 0x80) == 0)
+        {
+            // original values encoded with 7 bits if high bit is clear for all else 8 bits
+            uint32_t inPos2=inPos;
+            while (inPos2 < nValues)
+                highBitCheck |= inVals[inPos2++]; // check for remaining values with high bit clear
+            if ((highBitCheck & 0x80) == 0)
+                highBitClear = 1;
+        }
+        int32_t retBits=td64TextMode(inVals, outVals, nValues, val256, useExtendedTextMode, highBitClear, nUniqueVals, tableId, sizeOnly);
+        if (retBits != 0)
+            return retBits;
+    }
+    // continue fixed bit loop with check for single value
+    // perform this even when uniqueLimit is exceeded to do single value mode and string mode
+    const uint32_t minRepeatsSingleValueMode=nValues<16 ? nValues/2 : nValues/4+2;
+    int32_t singleValue=-1; // set to value if min repeats reached
+    while (inPos < nValues)
+    {
+        // will always complete this loop unless single value count reached
+        const uint32_t inVal=inVals[inPos++];
+        if (val256[inVal]++ == 0)
+        {
+         // first occurrence of value, for fixed bit coding:
+            uniqueOccurrence[inVal] = nUniqueVals; // save occurrence count for this unique
+            outVals[++nUniqueVals] = (unsigned char)inVal; // store unique starting at second byte
+            highBitCheck |= inVal;
+        }
+        else if (val256[inVal] >= minRepeatsSingleValueMode)
+        {
+            singleValue = (int32_t)inVal;
+            break; // continue loop without further checking
+        }
+    }
+    if (singleValue >= 0 && nUniqueVals > uniqueLimit)
+    {
+        // early opportunity for single value mode
+        // single value mode is fast and set to get minimum 12% compression for 64 values
+        // single value mode is not limited by MAX_STRING_MODE_UNIQUES
+        const uint32_t compressNSV=0; // don't compress non-single values when unique limit exceeded
+        return encodeSingleValueMode(inVals, outVals, nValues, singleValue, compressNSV, sizeOnly);
+    }
+    if (nUniqueVals <= uniqueLimit)
+    {
+        // continue fixed bit loop with checks for high bit set and repeat counts, but without single value
+        while (inPos < nValues)
+        {
+            const uint32_t inVal=inVals[inPos++];
+            if (val256[inVal]++ == 0)
+            {
+                // first occurrence of value, for fixed bit coding:
+                uniqueOccurrence[inVal] = nUniqueVals; // save occurrence count for this unique
+                outVals[++nUniqueVals] = (unsigned char)inVal; // store unique starting at second byte
+                highBitCheck |= inVal;
+            }
+        }
+    }
+    return td64EncodeModes(inVals, outVals, nValues, nUniqueVals, uniqueOccurrence, highBitCheck, singleValue, uniqueLimit, sizeOnly);
+} // end td64Encode
+
+static inline uint32_t deltaUniques(const unsigned char *inVals, const uint32_t nValues, const uint32_t stride, const uint32_t useXor)
+{
+    // number of uniques after the delta or XOR of values stride apart
+    // values before the first stride are unchanged: a stride of nValues counts the input uniques
+    uint64_t seen[4]={0};
+    uint32_t nUniques=0;
+    uint32_t i;
+    for (i=0; i<nValues; i++)
+    {
+        uint32_t deltaVal=inVals[i];
+        if (i >= stride)
+            deltaVal = useXor ? deltaVal ^ inVals[i-stride] : (unsigned char)(deltaVal - inVals[i-stride]);
+        const uint64_t deltaBit=1llu << (deltaVal & 63);
+        if ((seen[deltaVal >> 6] & deltaBit) == 0)
+        {
+            seen[deltaVal >> 6] |= deltaBit;
+            nUniques++;
+        }
+    }
+    return nUniques;
+} // end deltaUniques
+
+// numeric text codes: digits 0 to 9, then . - , : and the most frequent other value of the input, 15 is escape
+static const unsigned char numericTextChars[TD64_NUMERIC_TEXT_CODES]={'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', '-', ',', ':'};
+static const unsigned char numericTextCodes[256]={
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 12, 11, 10, 15, // , - .
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 13, 15, 15, 15, 15, 15, // 0...9 :
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15
+};
+
+uint32_t countNumericTextChars(const unsigned char *inVals, const uint32_t nValues)
+{
+    // number of digits and . - , : in the values
+    uint32_t nNumericChars=0;
+    uint32_t i;
+    for (i=0; i<nValues; i++)
+        nNumericChars += numericTextCodes[inVals[i]] < 14;
+    return nNumericChars;
+} // end countNumericTextChars
+
+static uint32_t numericTextBits(const unsigned char *inVals, const uint32_t nValues, uint32_t *otherVal)
+{
+    // bits output in numeric text mode, with the most frequent other value returned in otherVal
+    uint16_t otherCounts[256]={0};
+    uint32_t nOtherVals=0;
+    uint32_t i;
+    
+    *otherVal = 0;
+    for (i=0; i<nValues; i++)
+    {
+        const uint32_t inVal=inVals[i];
+        if (numericTextCodes[inVal] == 15)
+        {
+            nOtherVals++;
+            if (++otherCounts[inVal] > otherCounts[*otherVal])
+                *otherVal = inVal;
+        }
+    }
+    return 16 + nValues*4 + (nOtherVals - otherCounts[*otherVal])*8;
+} // end numericTextBits
+
+int32_t encodeNumericTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxBits)
+{
+    // output TD64_NUMERIC_TEXT_MODE, the value for code 14, then a 4-bit code for each value, low nibble first
+    // other values are escape code 15 followed by the value in two codes
+    // returns the number of bits output, or 0 if not fewer than maxBits
+    uint32_t otherVal;
+    uint32_t i;
+    
+    const uint32_t nBits=numericTextBits(inVals, nValues, &otherVal);
+    if (nBits >= maxBits)
+        return 0;
+    outVals[0] = TD64_NUMERIC_TEXT_MODE;
+    outVals[1] = (unsigned char)otherVal;
+    uint32_t outBits=0;
+    uint32_t nOutBits=0;
+    uint32_t outputOffset=2;
+    for (i=0; i<nValues; i++)
+    {
+        const uint32_t inVal=inVals[i];
+        uint32_t code=numericTextCodes[inVal];
+        uint32_t nCodeBits=4;
+        if (code == 15)
+        {
+            if (inVal == otherVal)
+                code = 14;
+            else
+            {
+                code |= inVal << 4; // escape then value
+                nCodeBits = 12;
+            }
+        }
+        outBits |= code << nOutBits;
+        nOutBits += nCodeBits;
+        while (nOutBits >= 8)
+        {
+            outVals[outputOffset++] = (unsigned char)outBits;
+            outBits >>= 8;
+            nOutBits -= 8;
+        }
+    }
+    if (nOutBits)
+        outVals[outputOffset] = (unsigned char)outBits;
+    return (int32_t)nBits;
+} // end encodeNumericTextMode
+
+int32_t numericTextModeBits(const unsigned char *inVals, const uint32_t nValues, const uint32_t maxBits)
+{
+    // bits output by encodeNumericTextMode without output, or 0 if not fewer than maxBits
+    uint32_t otherVal;
+    const uint32_t nBits=numericTextBits(inVals, nValues, &otherVal);
+    return nBits < maxBits ? (int32_t)nBits : 0;
+} // end numericTextModeBits
+
+static int32_t td64NumericTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t retBits, const uint32_t sizeOnly)
+{
+    // for digits with separators, encode in numeric text mode when it is smaller than retBits
+    unsigned char tempOutVals[MAX_TD64_BYTES+2];
+    const uint32_t maxBits=retBits > 0 ? (uint32_t)retBits : nValues*8-8;
+    int32_t retBitsNumeric;
+    
+    if (countNumericTextChars(inVals, nValues) < nValues*3/4)
+        return retBits; // too many escapes to do better
+    if (sizeOnly)
+    {
+        uint32_t otherVal;
+        const uint32_t numericBits=numericTextBits(inVals, nValues, &otherVal);
+        return numericBits < maxBits ? (int32_t)numericBits : retBits;
+    }
+    if ((retBitsNumeric=encodeNumericTextMode(inVals, tempOutVals, nValues, maxBits)) == 0)
+        return retBits;
+    memcpy(outVals, tempOutVals, (uint32_t)(retBitsNumeric+7)/8);
+    return retBitsNumeric;
+} // end td64NumericTextMode
+
+// alphabets of each value: 1 lowercase hex, 2 uppercase hex, 4 base64, 8 base64 with - and _ for URLs
+static const unsigned char alphabetFlags[256]={
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  4,  0,  8,  0,  4, // + - /
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  0,  0,  0,  0,  0,  0, // 0...9
+     0, 14, 14, 14, 14, 14, 14, 12, 12, 12, 12, 12, 12, 12, 12, 12, // A...O
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  0,  0,  0,  0,  8, // P...Z _
+     0, 13, 13, 13, 13, 13, 13, 12, 12, 12, 12, 12, 12, 12, 12, 12, // a...o
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  0,  0,  0,  0,  0, // p...z
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
+};
+static const char hexChars[2][16]={
+    {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'},
+    {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'}
+};
+static const char base64Chars[2][64]={
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+};
+
+uint32_t checkAlphabetMode(const unsigned char *inVals, const uint32_t nValues)
+{
+    // return the alphabet flags common to all values, ignoring up to two = at the end for base64
+    // 0 when the values are not all hex or base64 characters
+    uint32_t nAlphabetVals=nValues;
+    uint32_t flags=15;
+    uint32_t i;
+    
+    while (nAlphabetVals > 0 && nValues-nAlphabetVals < 2 && inVals[nAlphabetVals-1] == '=')
+        nAlphabetVals--;
+    for (i=0; i<nAlphabetVals; i++)
+    {
+        flags &= alphabetFlags[inVals[i]];
+        if (flags == 0)
+            return 0;
+    }
+    if (nAlphabetVals < nValues)
+        flags &= 12; // padding is base64 only
+    return flags;
+} // end checkAlphabetMode
+
+int32_t encodeAlphabetMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t flags)
+{
+    // for flags returned by checkAlphabetMode, output TD64_HEX_MODE or TD64_BASE64_MODE and a variant byte,
+    // then 4 bits for each hex value or 6 bits for each base64 value, low-order bits first
+    // hex variant is 1 for uppercase, base64 variant is 1 for - and _ plus twice the number of =
+    // returns the number of bits output
+    uint32_t outputOffset=2;
+    uint32_t i;
+    
+    if (flags & 3)
+    {
+        const uint32_t upperCase=(flags & 1) == 0;
+        const unsigned char *pHexChars=(const unsigned char *)hexChars[upperCase];
+        unsigned char hexCodes[256];
+        for (i=0; i<16; i++)
+            hexCodes[pHexChars[i]] = (unsigned char)i;
+        outVals[0] = TD64_HEX_MODE;
+        outVals[1] = (unsigned char)upperCase;
+        for (i=0; i+1<nValues; i+=2)
+            outVals[outputOffset++] = hexCodes[inVals[i]] | (unsigned char)(hexCodes[inVals[i+1]] << 4);
+        if (nValues & 1)
+            outVals[outputOffset] = hexCodes[inVals[nValues-1]];
+        return (int32_t)(16 + nValues*4);
+    }
+    const uint32_t urlSafe=(flags & 4) == 0;
+    const unsigned char *pBase64Chars=(const unsigned char *)base64Chars[urlSafe];
+    unsigned char base64Codes[256];
+    uint32_t nAlphabetVals=nValues;
+    uint32_t outBits=0;
+    uint32_t nOutBits=0;
+    for (i=0; i<64; i++)
+        base64Codes[pBase64Chars[i]] = (unsigned char)i;
+    while (nAlphabetVals > 0 && inVals[nAlphabetVals-1] == '=')
+        nAlphabetVals--;
+    outVals[0] = TD64_BASE64_MODE;
+    outVals[1] = (unsigned char)(urlSafe | (nValues-nAlphabetVals) << 1);
+    for (i=0; i<nAlphabetVals; i++)
+    {
+        outBits |= (uint32_t)base64Codes[inVals[i]] << nOutBits;
+        nOutBits += 6;
+        if (nOutBits >= 8)
+        {
+            outVals[outputOffset++] = (unsigned char)outBits;
+            outBits >>= 8;
+            nOutBits -= 8;
+        }
+    }
+    if (nOutBits)
+        outVals[outputOffset] = (unsigned char)outBits;
+    return (int32_t)(16 + nAlphabetVals*6);
+} // end encodeAlphabetMode
+
+int32_t alphabetModeBits(const unsigned char *inVals, const uint32_t nValues, const uint32_t flags)
+{
+    // bits output by encodeAlphabetMode, which does not encode the = padding of base64
+    uint32_t nAlphabetVals=nValues;
+    
+    if (flags & 3)
+        return (int32_t)(16 + nValues*4);
+    while (nAlphabetVals > 0 && inVals[nAlphabetVals-1] == '=')
+        nAlphabetVals--;
+    return (int32_t)(16 + nAlphabetVals*6);
+} // end alphabetModeBits
+
+static int32_t td64AlphabetMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t retBits, const uint32_t sizeOnly)
+{
+    // for hex and base64 strings, encode in 4 or 6 bits when smaller than retBits
+    const uint32_t flags=checkAlphabetMode(inVals, nValues);
+    unsigned char tempOutVals[MAX_TD64_BYTES+2];
+    int32_t retBitsAlphabet;
+    
+    if (flags == 0)
+        return retBits;
+    retBitsAlphabet = sizeOnly ? alphabetModeBits(inVals, nValues, flags) : encodeAlphabetMode(inVals, tempOutVals, nValues, flags);
+    if ((retBits > 0 && retBitsAlphabet >= retBits) || (uint32_t)retBitsAlphabet > nValues*8-8)
+        return retBits;
+    if (sizeOnly)
+        return retBitsAlphabet;
+    memcpy(outVals, tempOutVals, (uint32_t)(retBitsAlphabet+7)/8);
+    return retBitsAlphabet;
+} // end td64AlphabetMode
+
+// bits for the index of 1 to 16 nibbles
+static const uint32_t nibbleIndexBits[17]={0, 0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+
+static uint32_t nibbleIndexes(const uint32_t nibbleMask, unsigned char *nibbleVals, unsigned char *nibbleIx)
+{
+    // index of each nibble set in nibbleMask in increasing order, and the nibble of each index
+    // returns the number of nibbles
+    uint32_t nNibbles=0;
+    uint32_t i;
+    for (i=0; i<16; i++)
+    {
+        nibbleIx[i] = (unsigned char)nNibbles;
+        nibbleVals[nNibbles] = (unsigned char)i;
+        nNibbles += (nibbleMask >> i) & 1;
+    }
+    return nNibbles;
+} // end nibbleIndexes
+
+static inline void nibbleMasks(const unsigned char *inVals, const uint32_t nValues, uint32_t *highMask, uint32_t *lowMask)
+{
+    // 16-bit masks of the high nibbles and the low nibbles in the values
+    uint32_t i;
+    *highMask = 0;
+    *lowMask = 0;
+    for (i=0; i<nValues; i++)
+    {
+        *highMask |= 1u << (inVals[i] >> 4);
+        *lowMask |= 1u << (inVals[i] & 15);
+    }
+} // end nibbleMasks
+
+static int32_t encodeNibbleMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxBits)
+{
+    // output TD64_NIBBLE_MODE, 16-bit masks of the high nibbles and the low nibbles in the values,
+    // then for each value the index of its low nibble followed by the index of its high nibble, low-order bits first
+    // blocks with more than MAX_UNIQUES values often have few enough high and low nibbles, such as the fields of binary headers
+    // returns the number of bits output, or 0 if not fewer than maxBits
+    unsigned char nibbleVals[16];
+    unsigned char highIx[16];
+    unsigned char lowIx[16];
+    uint32_t highMask;
+    uint32_t lowMask;
+    uint32_t i;
+    
+    nibbleMasks(inVals, nValues, &highMask, &lowMask);
+    const uint32_t lowBits=nibbleIndexBits[nibbleIndexes(lowMask, nibbleVals, lowIx)];
+    const uint32_t valBits=lowBits + nibbleIndexBits[nibbleIndexes(highMask, nibbleVals, highIx)];
+    const uint32_t nBits=40 + nValues*valBits;
+    if (nBits >= maxBits)
+        return 0;
+    outVals[0] = TD64_NIBBLE_MODE;
+    outVals[1] = (unsigned char)highMask;
+    outVals[2] = (unsigned char)(highMask >> 8);
+    outVals[3] = (unsigned char)lowMask;
+    outVals[4] = (unsigned char)(lowMask >> 8);
+    uint64_t outBits=0;
+    uint32_t nOutBits=0;
+    uint32_t outputOffset=5;
+    for (i=0; i<nValues; i++)
+    {
+        outBits |= (uint64_t)(lowIx[inVals[i] & 15] | (uint32_t)highIx[inVals[i] >> 4] << lowBits) << nOutBits;
+        nOutBits += valBits;
+        if (nOutBits >= 32)
         {
-            if (nUniqueVals > MAX_UNIQUES)
-                return -5; // unexpected program error
-            // cases 9 through 16 take 4 bits to encode
-            // skipping last 3 bits in first byte to be on even byte boundary
-            outVals[0] = (unsigned char)((nUniqueVals-1) << 1);
-            nextOut = nUniqueVals + 1; // start output past uniques
-            i = 1; // first value is implied by first unique
-            while (i + 7 < nValues)
-            {
-                encodingByte = uniqueOccurrence[inVals[i++]];
-                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
-                encodingByte = uniqueOccurrence[inVals[i++]];
-                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
-                encodingByte = uniqueOccurrence[inVals[i++]];
-                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
-                encodingByte = uniqueOccurrence[inVals[i++]];
-                outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
-            }
-            while (i < nValues)
-            {
-                // 1 to 7 values remain
-                encodingByte = uniqueOccurrence[inVals[i++]];
-                if (i < nValues)
-                {
-                    outVals[nextOut++] = (unsigned char)(encodingByte | (uniqueOccurrence[inVals[i++]] << 4));
-                }
-                else
-                {
-                    outVals[nextOut] = (unsigned char)encodingByte;
-                    break;
-                }
-            }
-            return (int)(((nValues-1) * 4) + 8 + (nUniqueVals * 8)); // four bits for each value plus 8 indicator bits + 9 to 16 uniques
+            // write 4 bytes at a time
+            outVals[outputOffset++] = (unsigned char)outBits;
+            outVals[outputOffset++] = (unsigned char)(outBits >> 8);
+            outVals[outputOffset++] = (unsigned char)(outBits >> 16);
+            outVals[outputOffset++] = (unsigned char)(outBits >> 24);
+            outBits >>= 32;
+            nOutBits -= 32;
         }
     }
-    return -6; // unexpected program error
+    while (nOutBits > 0)
+    {
+        outVals[outputOffset++] = (unsigned char)outBits;
+        outBits >>= 8;
+        nOutBits = nOutBits > 8 ? nOutBits-8 : 0;
+    }
+    return (int32_t)nBits;
+} // end encodeNibbleMode
+
+static int32_t decodeNibbleMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+{
+    // decode the nibble indexes of encodeNibbleMode with the nibbles of each index
+    unsigned char highVals[16];
+    unsigned char lowVals[16];
+    unsigned char nibbleIx[16];
+    const uint32_t highMask=inVals[1] | (uint32_t)inVals[2] << 8;
+    const uint32_t lowMask=inVals[3] | (uint32_t)inVals[4] << 8;
+    uint32_t inBits=0;
+    uint32_t nInBits=0;
+    uint32_t inputOffset=5;
+    uint32_t i;
+    
+    if (highMask == 0 || lowMask == 0)
+        return -20; // no nibbles in a mask
+    const uint32_t lowBits=nibbleIndexBits[nibbleIndexes(lowMask, lowVals, nibbleIx)];
+    const uint32_t valBits=lowBits + nibbleIndexBits[nibbleIndexes(highMask, highVals, nibbleIx)];
+    const uint32_t lowIxMask=(1u << lowBits) - 1;
+    const uint32_t highIxMask=(1u << (valBits-lowBits)) - 1;
+    for (i=0; i<nOriginalValues; i++)
+    {
+        while (nInBits < valBits)
+        {
+            inBits |= (uint32_t)inVals[inputOffset++] << nInBits;
+            nInBits += 8;
+        }
+        const uint32_t code=inBits;
+        outVals[i] = (unsigned char)(highVals[(code >> lowBits) & highIxMask] << 4 | lowVals[code & lowIxMask]);
+        inBits >>= valBits;
+        nInBits -= valBits;
+    }
+    *bytesProcessed = inputOffset;
+    return (int32_t)nOriginalValues;
+} // end decodeNibbleMode
+
+static uint32_t nibbleModeBits(const unsigned char *inVals, const uint32_t nValues)
+{
+    // bits output by encodeNibbleMode
+    unsigned char nibbleVals[16];
+    unsigned char nibbleIx[16];
+    uint32_t highMask;
+    uint32_t lowMask;
+    
+    nibbleMasks(inVals, nValues, &highMask, &lowMask);
+    return 40 + nValues*(nibbleIndexBits[nibbleIndexes(highMask, nibbleVals, nibbleIx)] + nibbleIndexBits[nibbleIndexes(lowMask, nibbleVals, nibbleIx)]);
+} // end nibbleModeBits
+
+static int32_t td64NibbleMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t retBits, const uint32_t sizeOnly)
+{
+    // encode the high and low nibbles of each value separately when smaller than retBits
+    unsigned char tempOutVals[MAX_TD64_BYTES+5];
+    const uint32_t maxBits=retBits > 0 ? (uint32_t)retBits : nValues*8-8;
+    int32_t retBitsNibble;
+    
+    if (sizeOnly)
+    {
+        const uint32_t nibbleBits=nibbleModeBits(inVals, nValues);
+        return nibbleBits < maxBits ? (int32_t)nibbleBits : retBits;
+    }
+    if ((retBitsNibble=encodeNibbleMode(inVals, tempOutVals, nValues, maxBits)) == 0)
+        return retBits;
+    memcpy(outVals, tempOutVals, (uint32_t)(retBitsNibble+7)/8);
+    return retBitsNibble;
+} // end td64NibbleMode
+
+static inline uint64_t bigDeltas(const uint64_t vals, const uint64_t prevVals)
+{
+    // for each of the 8 bytes, set the high bit when the byte of vals minus the byte of prevVals is not from -4 to 4
+    const uint64_t highBits=0x8080808080808080llu;
+    const uint64_t deltas=((vals | highBits) - (prevVals & ~highBits)) ^ ((vals ^ ~prevVals) & highBits);
+    const uint64_t shiftedDeltas=((deltas & ~highBits) + 0x0404040404040404llu) ^ (deltas & highBits); // -4 to 4 is now 0 to 8
+    return (((shiftedDeltas & ~highBits) + 0x7777777777777777llu) | shiftedDeltas) & highBits;
+} // end bigDeltas
+
+static inline uint32_t steadyDeltas(const unsigned char *inVals, const uint32_t firstVal, const uint32_t stride)
+{
+    // number of the 8 deltas from firstVal that are from -4 to 4 and followed by a delta from -4 to 4 one stride later
+    // the 8 deltas are checked together in the bytes of 64-bit values
+    uint64_t prevVals, vals, nextVals;
+    memcpy(&prevVals, inVals+firstVal-stride, 8);
+    memcpy(&vals, inVals+firstVal, 8);
+    memcpy(&nextVals, inVals+firstVal+stride, 8);
+    const uint64_t steady=~(bigDeltas(vals, prevVals) | bigDeltas(nextVals, vals)) & 0x8080808080808080llu;
+    return (uint32_t)(((steady >> 7) * 0x0101010101010101llu) >> 56);
+} // end steadyDeltas
+
+static uint32_t deltaModeStride(const unsigned char *inVals, const uint32_t nValues)
+{
+    // the stride of 1, 2, 4 or 8 with the most steady deltas in the first and last 8 deltas, such as those of counters
+    // or of the high-order bytes of floating point fields
+    // returns 0 when no stride has 6, which is most text and random data, so that their uniques are not counted
+    // the last 8 deltas are only checked when 3 of the first 8 are steady, which text and random data rarely pass
+    static const uint32_t strides[4]={1, 2, 4, 8};
+    uint32_t bestStride=0;
+    uint32_t bestSteadyDeltas=5;
+    uint32_t i;
+    
+    for (i=0; i<4 && strides[i]*2+8 <= nValues; i++)
+    {
+        const uint32_t stride=strides[i];
+        uint32_t nSteadyDeltas=steadyDeltas(inVals, stride, stride);
+        if (nSteadyDeltas < 3)
+            continue;
+        nSteadyDeltas += steadyDeltas(inVals, nValues-stride-8, stride);
+        if (nSteadyDeltas > bestSteadyDeltas)
+        {
+            bestSteadyDeltas = nSteadyDeltas;
+            bestStride = stride;
+        }
+    }
+    return bestStride;
+} // end deltaModeStride
+
+static uint32_t deltaModeVals(const unsigned char *inVals, const uint32_t nValues, unsigned char *deltaVals, uint32_t *useXor)
+{
+    // for the stride from deltaModeStride, check the uniques in the delta or XOR of the first 32 values,
+    // and output the deltas to deltaVals
+    // returns the stride, or 0 when too few uniques are removed for delta mode to do better
+    const uint32_t nCheckVals=nValues < 32 ? nValues : 32; // check the uniques of the first 32 values
+    const uint32_t bestStride=deltaModeStride(inVals, nValues);
+    uint32_t i;
+    
+    if (bestStride == 0)
+        return 0;
+    const uint32_t bestUniques=deltaUniques(inVals, nCheckVals, bestStride, 0);
+    if (bestUniques*3 > deltaUniques(inVals, nCheckVals, nCheckVals, 0)*2)
+        return 0;
+    *useXor = 0;
+    if (deltaUniques(inVals, nCheckVals, bestStride, 1) < bestUniques)
+        *useXor = TD64_DELTA_XOR; // XOR does better for fields such as floating point
+    memcpy(deltaVals, inVals, bestStride);
+    for (i=bestStride; i<nValues; i++)
+        deltaVals[i] = *useXor ? inVals[i] ^ inVals[i-bestStride] : (unsigned char)(inVals[i] - inVals[i-bestStride]);
+    return bestStride;
+} // end deltaModeVals
+
+static int32_t td64DeltaMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t retBits, const uint32_t sizeOnly)
+{
+    // for counters and other slowly varying fields, take the delta or XOR of values 1, 2, 4 or 8 bytes apart
+    // and encode the result with td64 when it has fewer uniques than the input
+    // TD64_DELTA_MODE is followed by a byte with the stride and TD64_DELTA_XOR, then the td64 encoding
+    // returns retBits with outVals unchanged unless delta mode is smaller
+    unsigned char deltaVals[MAX_TD64_BYTES+1]; // string mode reads one value past its input
+    unsigned char tempOutVals[MAX_TD64_BYTES+18];
+    uint32_t useXor;
+    int32_t retBitsDelta;
+    
+    const uint32_t bestStride=deltaModeVals(inVals, nValues, deltaVals, &useXor);
+    if (bestStride == 0)
+        return retBits; // too few uniques removed to do better
+    if ((retBitsDelta=td64Encode(deltaVals, tempOutVals+2, nValues, -1, sizeOnly)) <= 0)
+        return retBitsDelta < 0 ? retBitsDelta : retBits;
+    retBitsDelta += 16;
+    if (retBits > 0 && retBitsDelta >= retBits)
+        return retBits;
+    if (sizeOnly)
+        return retBitsDelta;
+    tempOutVals[0] = TD64_DELTA_MODE;
+    tempOutVals[1] = (unsigned char)(bestStride | useXor);
+    memcpy(outVals, tempOutVals, (uint32_t)(retBitsDelta+7)/8);
+    return retBitsDelta;
+} // end td64DeltaMode
+
+static int32_t td64SelectModes(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId, const uint32_t sizeOnly)
+{
+    // select the mode of td64 and encode it, or when sizeOnly is set return its bits without output
+    // text mode uses registered table tableId, or the predefined tables when tableId is -1
+    if (nValues >= MIN_VALUES_DELTA_MODE)
+    {
+        // hex values are encoded in alphabet mode without trying other modes
+        // base64 values may have few enough uniques for other modes to do better
+        const uint32_t flags=checkAlphabetMode(inVals, nValues);
+        if (flags & 3)
+            return sizeOnly ? alphabetModeBits(inVals, nValues, flags) : encodeAlphabetMode(inVals, outVals, nValues, flags);
+    }
+    const int32_t retBits=td64Encode(inVals, outVals, nValues, tableId, sizeOnly);
+    if (retBits < 0 || nValues < MIN_VALUES_DELTA_MODE || (retBits > 0 && (uint32_t)retBits <= nValues*4))
+        return retBits; // alphabet, numeric text and delta modes are tried when compression is less than 50%
+    if (retBits == 0 && outVals[0] == 0)
+        return 0; // random data failure in first check
+    const int32_t retBitsAlphabet=td64AlphabetMode(inVals, outVals, nValues, retBits, sizeOnly);
+    if (retBitsAlphabet != retBits)
+        return retBitsAlphabet;
+    const int32_t retBitsNumeric=td64NumericTextMode(inVals, outVals, nValues, retBits, sizeOnly);
+    if (retBitsNumeric != retBits)
+        return retBitsNumeric;
+    return td64DeltaMode(inVals, outVals, nValues, td64NibbleMode(inVals, outVals, nValues, retBits, sizeOnly), sizeOnly);
+} // end td64SelectModes
+
+int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+// td64: Compress nValues bytes. Return 0 if not compressible (no output bytes),
+//    negative value if error; otherwise, number of bits written to outVals.
+//    Management of whether compressible and number of input values must be maintained
+//    by caller. Decdode requires number of input values and only accepts compressed data.
+// Arguments:
+//   inVals   input byte values
+//   outVals  output byte values if compressed, max of inVals bytes
+//   nValues  number of input byte values
+// Returns number of bits compressed, 0 if not compressed, or negative value if error
+{
+    return td64SelectModes(inVals, outVals, nValues, -1, 0);
 } // end td64
 
+int32_t td64_table(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId)
+// td64_table: same as td64 with text mode encoding with the table registered as tableId
+//    by td64RegisterTextTable, or with the predefined tables when tableId is -1. Decoded by td64d
+//    when the same table is registered.
+// Returns number of bits compressed, 0 if not compressed, or negative value if error
+{
+    int32_t retVal;
+    if ((retVal=td64CheckTextTable(tableId)) < 0)
+        return retVal;
+    return td64SelectModes(inVals, outVals, nValues, tableId, 0);
+} // end td64_table
+
+int32_t td64TableSized(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId, const uint32_t sizeOnly)
+{
+    // td64_table for a tableId already checked, or when sizeOnly is set the bits td64_estimate returns for it
+    // with outVals not written
+    unsigned char tempOutVals[MAX_TD64_BYTES*2]; // uniques and info bytes that modes write while sizing
+    
+    return td64SelectModes(inVals, sizeOnly ? tempOutVals : outVals, nValues, tableId, sizeOnly);
+} // end td64TableSized
+
+int32_t td64Analyzed(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const td64Analysis *analysis)
+// td64Analyzed: same as td64 but uses the analysis of inVals already done by the caller
+//    rather than building the uniques and counts again. See td64Analysis.
+// Returns number of bits compressed, 0 if not compressed, or negative value if error
+{
+    if (nValues <= 5)
+        return td5(inVals, outVals, nValues);
+    
+    if (nValues > MAX_TD64_BYTES)
+        return -1; // only values 1 to 64 supported
+    
+    const uint32_t uniqueLimit=uniqueLimits25[nValues]; // if exceeded, cannot use fixed bit coding
+    const uint32_t nValsInitLoop=nValues<24 ? nValues/2 : nValues*7/16;
+    const uint32_t nUniqueVals=analysis->nUniqueVals;
+    memcpy(outVals+1, analysis->uniques, nUniqueVals); // store uniques starting at second byte
+    if (analysis->nUniqueValsInitLoop > nValsInitLoop - nValsInitLoop/8 - 1 && (analysis->highBitCheckInitLoop & 0x80))
+    {
+        // unique values exceed usual count to be compressed and high bit across tested values is not 0
+        outVals[0] = 0; // indicate random data failure in first check
+        return 0;
+    }
+    if (analysis->nUniqueValsInitLoop > uniqueLimit/2 && analysis->predefinedTextCharCnt > nValsInitLoop/2)
+    {
+        // encode in text mode if at least 11% compression expected
+        const uint32_t useExtendedTextMode=analysis->predefinedTextCharCnt >= nValsInitLoop*7/8;
+        const uint32_t highBitClear=(analysis->highBitCheck & 0x80) == 0;
+        int32_t retBits=td64TextMode(inVals, outVals, nValues, analysis->val256, useExtendedTextMode, highBitClear, nUniqueVals, analysis->tableId, 0);
+        if (retBits != 0)
+            return retBits;
+    }
+    const int32_t retBits=td64EncodeModes(inVals, outVals, nValues, nUniqueVals, analysis->uniqueOccurrence, analysis->highBitCheck, analysis->singleValue, uniqueLimit, 0);
+    if (retBits < 0 || (retBits > 0 && (uint32_t)retBits <= nValues*4))
+        return retBits;
+    const int32_t retBitsAlphabet=td64AlphabetMode(inVals, outVals, nValues, retBits, 0);
+    if (retBitsAlphabet != retBits)
+        return retBitsAlphabet;
+    const int32_t retBitsNumeric=td64NumericTextMode(inVals, outVals, nValues, retBits, 0);
+    if (retBitsNumeric != retBits)
+        return retBitsNumeric;
+    return td64DeltaMode(inVals, outVals, nValues, td64NibbleMode(inVals, outVals, nValues, retBits, 0), 0);
+} // end td64Analyzed
+
+int32_t td64_estimate(const unsigned char *inVals, const uint32_t nValues)
+// td64_estimate: number of bits td64 outputs for nValues bytes. Modes are selected by the same code as td64,
+//    with fixed bit coding, 7-bit, hex, base64, numeric text and nibble modes returning their bits without output.
+//    Text, string and single value modes count the bits of each value without writing them.
+// Returns number of bits td64 outputs, 0 if td64 does not compress, in which case the nValues bytes are stored
+//    as they are, or negative value if error
+{
+    unsigned char tempOutVals[MAX_TD64_BYTES*2]; // uniques and info bytes that modes write while sizing
+    
+    return td64SelectModes(inVals, tempOutVals, nValues, -1, 1);
+} // end td64_estimate
+
 static inline void dtbmPeekBits(const uint32_t nBitsToPeak, uint32_t bitPos, uint32_t *theBits, uint32_t *dtbmThisInVal)
 {
     // peek works for up to 8 bits, using next 8 bits already in dtbmThisInVal
@@ -1485,6 +2575,96 @@ static const uint32_t textDecodeBits[128]={
     3,5,3,5,3,5,4,5,3,5,3,5,3,7,4
 };
 
+static int32_t decodeBigramTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+{
+    // decode the 2- to 8-bit codes of encodeBigramTextMode with a table of the values each code outputs,
+    // writing two values for every code while two or more values remain
+    // nOriginalValues may be fewer than were encoded, such as for a prefix: a bigram that starts at the last value
+    // outputs only its first value
+    // as with decodeAdaptiveTextMode, one byte may be read beyond the encoded values
+    const uint32_t input7or8=(inVals[0] & 0x80) ? 7 : 8;
+    const uint32_t *pSymbols=predefinedBigramSymbols;
+    uint32_t thisInValIx=1; // start past first info byte
+    uint32_t nextOutVal=0;
+    uint64_t inBits=0;
+    uint32_t nInBits=0;
+    
+    if (initBigramText == 0)
+        initBigramTextMode();
+    if ((inVals[0] & 0x7f) == TD64_TRAINED_BIGRAM_MODE)
+    {
+        // registered table id follows the info byte
+        const uint32_t tableId=inVals[1];
+        if (tableId >= TD64_MAX_TEXT_TABLES || trainedBigramsSet[tableId] == 0)
+            return -14; // table or bigrams not registered
+        pSymbols = trainedBigramSymbols[tableId];
+        thisInValIx = 2;
+    }
+    while (nextOutVal + 64 <= nOriginalValues)
+    {
+        // at least 2 bits are encoded for each value, so the 8 bytes read to refill are within the encoded values
+        uint64_t nextBits;
+        uint32_t i;
+        memcpy(&nextBits, inVals+thisInValIx, 8);
+        inBits |= nextBits << nInBits;
+        thisInValIx += (63 - nInBits) >> 3;
+        nInBits |= 56;
+        for (i=0; i<3; i++)
+        {
+            // 3 codes of up to 16 bits each with an escaped value
+            const uint32_t symbol=bigramTextDecode[inBits & 0xff];
+            const uint32_t symbolVals=pSymbols[symbol];
+            inBits >>= bigramTextNBits[symbol];
+            nInBits -= bigramTextNBits[symbol];
+            if (symbol == BIGRAM_TEXT_ESCAPE)
+            {
+                outVals[nextOutVal++] = (unsigned char)(inBits & (0xff >> (8-input7or8)));
+                inBits >>= input7or8;
+                nInBits -= input7or8;
+                continue;
+            }
+            outVals[nextOutVal] = (unsigned char)symbolVals;
+            outVals[nextOutVal+1] = (unsigned char)(symbolVals >> 8);
+            nextOutVal += symbolVals >> 16;
+        }
+    }
+    while (nextOutVal < nOriginalValues)
+    {
+        if (nInBits < 8)
+        {
+            inBits |= (uint64_t)inVals[thisInValIx++] << nInBits;
+            nInBits += 8;
+        }
+        const uint32_t symbol=bigramTextDecode[inBits & 0xff];
+        inBits >>= bigramTextNBits[symbol];
+        nInBits -= bigramTextNBits[symbol];
+        if (symbol == BIGRAM_TEXT_ESCAPE)
+        {
+            // 7- or 8-bit value
+            if (nInBits < input7or8)
+            {
+                inBits |= (uint64_t)inVals[thisInValIx++] << nInBits;
+                nInBits += 8;
+            }
+            outVals[nextOutVal++] = (unsigned char)(inBits & (0xff >> (8-input7or8)));
+            inBits >>= input7or8;
+            nInBits -= input7or8;
+            continue;
+        }
+        const uint32_t symbolVals=pSymbols[symbol];
+        if (nextOutVal+1 < nOriginalValues)
+        {
+            outVals[nextOutVal] = (unsigned char)symbolVals;
+            outVals[nextOutVal+1] = (unsigned char)(symbolVals >> 8);
+            nextOutVal += symbolVals >> 16;
+        }
+        else
+            outVals[nextOutVal++] = (unsigned char)symbolVals; // first value of a bigram past the last value
+    }
+    *bytesProcessed = thisInValIx - nInBits / 8;
+    return (int32_t)nextOutVal;
+} // end decodeBigramTextMode
+
 int32_t decodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
 {
     // One byte is read ahead, which means that one byte is read beyond the input array, which requires allocation of one byte more that stored values. This can be addressed in a future version of the code.
@@ -1501,7 +2681,18 @@ int32_t decodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVa
     const uint32_t *pTextChars; // points to text chars encoded with
     const uint32_t input7or8=(inVals[0] & 0x80) ? 7 : 8; // high bit of info bit indicates whether unreplaced values output as 7 or 8 bits
     
-    if ((inVals[0] & 0x3f) == 0x17)
+    if (inVals[0] & 0x40)
+        return decodeBigramTextMode(inVals, outVals, nOriginalValues, bytesProcessed);
+    if ((inVals[0] & 0x3f) == TD64_TRAINED_TEXT_MODE)
+    {
+        // registered table id follows the info byte
+        const uint32_t tableId=inVals[1];
+        if (tableId >= TD64_MAX_TEXT_TABLES || trainedTextTableSet[tableId] == 0)
+            return -14; // table not registered
+        pTextChars = trainedTextChars[tableId];
+        thisInValIx = 2;
+    }
+    else if ((inVals[0] & 0x3f) == 0x17)
         pTextChars = XMLTextChars;
     else if ((inVals[0] & 0x3f) == 0x27)
         pTextChars = CTextChars;
@@ -1509,7 +2700,7 @@ int32_t decodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVa
         pTextChars=extendedTextChars;
     uint32_t dtbmThisInVal = inVals[thisInValIx]; // initialize to first input val to decode
     dtbmThisInVal |= (uint32_t)inVals[thisInValIx+1] << 8; // keep next value handy for peek
-    while (nextOutVal < nOriginalValues-3)
+    while (nextOutVal + 3 < nOriginalValues)
     {
         // peak at the next 7 bits to decide what to do
         dtbmPeekBits(7, bitPos, &theBits, &dtbmThisInVal);
@@ -1742,31 +2933,9 @@ int32_t decode7bits(const unsigned char *inVals, unsigned char *outVals, const u
         outVals[nextOutVal++] = (unsigned char)(((val1 << 6) & 127) | (val2 >> 2));
         outVals[nextOutVal++] = (unsigned char)val1 >> 1;
     }
-    while (nextOutVal < nOriginalValues)
-    {
-        // output final values as full bytes because no bytes saved, only bits
-        outVals[nextOutVal++] = inVals[nextInVal++];
-        if (nextOutVal == nOriginalValues)
-            break;
-        outVals[nextOutVal++] = inVals[nextInVal++];
-        if (nextOutVal == nOriginalValues)
-            break;
-        outVals[nextOutVal++] = inVals[nextInVal++];
-        if (nextOutVal == nOriginalValues)
-            break;
-        outVals[nextOutVal++] = inVals[nextInVal++];
-        if (nextOutVal == nOriginalValues)
-            break;
-        outVals[nextOutVal++] = inVals[nextInVal++];
-        if (nextOutVal == nOriginalValues)
-            break;
-        outVals[nextOutVal++] = inVals[nextInVal++];
-        if (nextOutVal == nOriginalValues)
-            break;
-        outVals[nextOutVal++] = inVals[nextInVal++];
-            break;
-    }
-    *bytesProcessed = nextInVal;
+    // final values are full bytes because no bytes saved, only bits
+    memcpy(outVals+nextOutVal, inVals+nextInVal, nOriginalValues-nextOutVal);
+    *bytesProcessed = nextInVal + nOriginalValues-nextOutVal;
     return (int32_t)nOriginalValues;
 } // end decode7bits
 
@@ -1926,16 +3095,138 @@ int32_t decodeStringMode(const unsigned char *inVals, unsigned char *outVals, co
     return (int32_t)nOriginalValues;
 } // end decodeStringMode
 
-int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
-// decoding requires number of original values and encoded bytes
-// uncompressed data is not acceppted
-// encoding for 1 to 64 input values.
-// 1 to 5 input values are handled separately.
-// inVals   compressed data with fewer bits than in original values
-// outVals  decompressed data
-// nOriginalalues  number of values in the original input to td64: required input
-// return number of bytes output or -1 if error
+int32_t decodeSharedUniquesMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, const unsigned char *sharedUniques, const uint32_t nSharedUniques, uint32_t *bytesProcessed)
+{
+    // decode a block encoded by encodeSharedUniquesMode using the unique table provided by td512d
+    uint32_t nextOutVal=0;
+    uint32_t thisInValIx=1; // start past mode byte
+    uint64_t inBits=0;
+    uint32_t nInBits=0;
+    
+    if (nSharedUniques == 0 || nSharedUniques > MAX_UNIQUES)
+        return -11;
+    if (nSharedUniques == 1)
+    {
+        memset(outVals, sharedUniques[0], nOriginalValues);
+        *bytesProcessed = 1;
+        return (int32_t)nOriginalValues;
+    }
+    const uint32_t nBits=encodingBits[nSharedUniques-1];
+    const uint32_t mask=bitMask[nBits];
+    while (nextOutVal < nOriginalValues)
+    {
+        if (nInBits < nBits)
+        {
+            inBits |= (uint64_t)inVals[thisInValIx++] << nInBits;
+            nInBits += 8;
+        }
+        outVals[nextOutVal++] = sharedUniques[inBits & mask];
+        inBits >>= nBits;
+        nInBits -= nBits;
+    }
+    *bytesProcessed = thisInValIx;
+    return (int32_t)nOriginalValues;
+} // end decodeSharedUniquesMode
+
+int32_t decodeNumericTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+{
+    // decode values encoded by encodeNumericTextMode
+    unsigned char codeChars[TD64_NUMERIC_TEXT_CODES];
+    uint32_t codePos=4; // nibble position past the mode byte and code 14 value
+    uint32_t i;
+    
+    memcpy(codeChars, numericTextChars, 14);
+    codeChars[14] = inVals[1];
+    for (i=0; i<nOriginalValues; i++)
+    {
+        const uint32_t code=(inVals[codePos >> 1] >> ((codePos & 1) * 4)) & 15;
+        codePos++;
+        if (code == 15)
+        {
+            // escaped value in the next two codes
+            uint32_t escapedVal=(inVals[codePos >> 1] >> ((codePos & 1) * 4)) & 15;
+            codePos++;
+            escapedVal |= ((inVals[codePos >> 1] >> ((codePos & 1) * 4)) & 15) << 4;
+            codePos++;
+            outVals[i] = (unsigned char)escapedVal;
+        }
+        else
+            outVals[i] = codeChars[code];
+    }
+    *bytesProcessed = (codePos + 1) >> 1;
+    return (int32_t)nOriginalValues;
+} // end decodeNumericTextMode
+
+int32_t decodeAlphabetMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+{
+    // decode values encoded by encodeAlphabetMode
+    uint32_t inputOffset=2;
+    uint32_t i;
+    
+    if (inVals[0] == TD64_HEX_MODE)
+    {
+        if (inVals[1] > 1)
+            return -17; // unknown variant
+        const char *pHexChars=hexChars[inVals[1]];
+        for (i=0; i+1<nOriginalValues; i+=2)
+        {
+            const uint32_t inVal=inVals[inputOffset++];
+            outVals[i] = (unsigned char)pHexChars[inVal & 15];
+            outVals[i+1] = (unsigned char)pHexChars[inVal >> 4];
+        }
+        if (nOriginalValues & 1)
+            outVals[nOriginalValues-1] = (unsigned char)pHexChars[inVals[inputOffset++] & 15];
+        *bytesProcessed = inputOffset;
+        return (int32_t)nOriginalValues;
+    }
+    const uint32_t nPadVals=inVals[1] >> 1;
+    if (nPadVals > 2 || nPadVals > nOriginalValues)
+        return -17;
+    const char *pBase64Chars=base64Chars[inVals[1] & 1];
+    const uint32_t nAlphabetVals=nOriginalValues-nPadVals;
+    uint32_t inBits=0;
+    uint32_t nInBits=0;
+    for (i=0; i<nAlphabetVals; i++)
+    {
+        if (nInBits < 6)
+        {
+            inBits |= (uint32_t)inVals[inputOffset++] << nInBits;
+            nInBits += 8;
+        }
+        outVals[i] = (unsigned char)pBase64Chars[inBits & 63];
+        inBits >>= 6;
+        nInBits -= 6;
+    }
+    memset(outVals+nAlphabetVals, '=', nPadVals);
+    *bytesProcessed = inputOffset;
+    return (int32_t)nOriginalValues;
+} // end decodeAlphabetMode
+
+int32_t decodeDeltaMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+{
+    // decode the td64 encoding that follows the mode and stride bytes, then undo the delta or XOR
+    const uint32_t stride=inVals[1] & 0xf;
+    int32_t retVals;
+    uint32_t i;
+    
+    if (stride == 0 || stride > 8 || inVals[2] == TD64_DELTA_MODE)
+        return -16;
+    if ((retVals=td64d(inVals+2, outVals, nOriginalValues, bytesProcessed)) < 0)
+        return retVals;
+    if (inVals[1] & TD64_DELTA_XOR)
+        for (i=stride; i<nOriginalValues; i++)
+            outVals[i] ^= outVals[i-stride];
+    else
+        for (i=stride; i<nOriginalValues; i++)
+            outVals[i] += outVals[i-stride];
+    *bytesProcessed += 2;
+    return retVals;
+} // end decodeDeltaMode
+
+static inline int32_t td64dInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed, const uint32_t wildCopy)
 {
+    // wildCopy 1: fixed bit coding outputs whole groups of values into the TD64D_OUTPUT_SLACK bytes past outVals
+    //    and reads up to 2 bytes past the encoded values rather than handling the final values separately
     if (nOriginalValues <= 5)
         return td5d(inVals, outVals, nOriginalValues, bytesProcessed);
     
@@ -1949,6 +3240,36 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
         // string mode extended
         return decodeExtendedStringMode(inVals, outVals, nOriginalValues, bytesProcessed);
     }
+    if (firstByte == TD64_SHARED_UNIQUES_MODE)
+    {
+        // unique table is held by td512d: use decodeSharedUniquesMode
+        return -12;
+    }
+    if (firstByte == TD64_PRIMED_STRING_MODE)
+    {
+        // dictionary is held by a td512ctx: use td512d_ctx
+        return -13;
+    }
+    if (firstByte == TD64_HEX_MODE || firstByte == TD64_BASE64_MODE)
+    {
+        // 4 or 6 bits for hex or base64 characters
+        return decodeAlphabetMode(inVals, outVals, nOriginalValues, bytesProcessed);
+    }
+    if (firstByte == TD64_NIBBLE_MODE)
+    {
+        // separate codes for high and low nibbles
+        return decodeNibbleMode(inVals, outVals, nOriginalValues, bytesProcessed);
+    }
+    if (firstByte == TD64_NUMERIC_TEXT_MODE)
+    {
+        // 4-bit codes for digits and separators
+        return decodeNumericTextMode(inVals, outVals, nOriginalValues, bytesProcessed);
+    }
+    if (firstByte == TD64_DELTA_MODE)
+    {
+        // td64 encoding of the delta or XOR of values stride apart
+        return decodeDeltaMode(inVals, outVals, nOriginalValues, bytesProcessed);
+    }
     if ((firstByte & 7) == 0x01)
     {
         // string mode
@@ -1999,7 +3320,7 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
             outVals[3] = (unsigned char)(((firstByte >> 7) & 1) ? uniques2 : uniques1);
             nextInVal=3;
             nextOutVal=4;
-            while (nextOutVal+7 < nOriginalValues)
+            while (nextOutVal+7 < nOriginalValues+wildCopy*7)
             {
                 inByte = inVals[nextInVal++];
                 outVals[nextOutVal++] = (unsigned char)((inByte & 1) ? uniques2 : uniques1);
@@ -2034,7 +3355,7 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
                     break;
                 outVals[nextOutVal++] = (unsigned char)((inByte & 64) ? uniques2 : uniques1);
             }
-            *bytesProcessed = nextInVal;
+            *bytesProcessed = 3 + (nOriginalValues-4+7)/8;
             return (int)nOriginalValues;
         }
         case 3:
@@ -2054,7 +3375,8 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
             outVals[0] = (unsigned char)uniques[0];
             outVals[1] = (unsigned char)uniques[(firstByte >> 5)&3];
             nextOutVal = 2; // skip high bit of first byte
-            while (nextOutVal + 3 < nOriginalValues)
+            const uint32_t firstInVal=nextInVal;
+            while (nextOutVal + 3 < nOriginalValues+wildCopy*3)
             {
                 inByte = inVals[nextInVal++];
                 outVals[nextOutVal++] = (unsigned char)uniques[inByte&3];
@@ -2073,7 +3395,7 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
                     break;
                 outVals[nextOutVal++] = (unsigned char)uniques[(inByte>>4)&3];
             }
-            *bytesProcessed = nextInVal;
+            *bytesProcessed = firstInVal + (nOriginalValues-2+3)/4;
             return (int)nOriginalValues;
         }
         case 5:
@@ -2090,7 +3412,7 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
             nextOutVal = 2;
             uint32_t inByte2;
             uint32_t inByte3;
-            while (nextOutVal + 7 < nOriginalValues)
+            while (nextOutVal + 7 < nOriginalValues+wildCopy*7)
             {
                 inByte = inVals[nextInVal++];
                 inByte2 = inVals[nextInVal++];
@@ -2129,7 +3451,7 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
                     break;
                 outVals[nextOutVal++] = (unsigned char)uniques[(inByte3>>2)&7];
             }
-            *bytesProcessed = nextInVal;
+            *bytesProcessed = nUniques + 1 + ((nOriginalValues-2)*3+7)/8;
             return (int)nOriginalValues;
         }
         default:
@@ -2142,7 +3464,7 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
             nextInVal = nUniques + 1; // skip past uniques
             outVals[0] = (unsigned char)uniques[0];
             nextOutVal = 1;
-            while (nextOutVal + 3 < nOriginalValues)
+            while (nextOutVal + 3 < nOriginalValues+wildCopy*3)
             {
                 inByte = inVals[nextInVal++];
                 outVals[nextOutVal++] = (unsigned char)uniques[inByte&0xf];
@@ -2164,9 +3486,30 @@ int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_
                 if (nextOutVal < nOriginalValues)
                     outVals[nextOutVal++] = (unsigned char)uniques[inVals[nextInVal++] & 0xf];
             }
-            *bytesProcessed = nextInVal;
+            *bytesProcessed = nUniques + 1 + (nOriginalValues-1+1)/2;
             return (int)nOriginalValues;
         }
     }
     return -8; // unexpected program error
+} // end td64dInternal
+
+int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+// decoding requires number of original values and encoded bytes
+// uncompressed data is not acceppted
+// encoding for 1 to 64 input values.
+// 1 to 5 input values are handled separately.
+// inVals   compressed data with fewer bits than in original values
+// outVals  decompressed data
+// nOriginalalues  number of values in the original input to td64: required input
+// return number of bytes output or -1 if error
+{
+    return td64dInternal(inVals, outVals, nOriginalValues, bytesProcessed, 0);
 } // end td64d
+
+int32_t td64d_slack(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+// td64d_slack: same as td64d but outVals must have TD64D_OUTPUT_SLACK bytes past nOriginalValues,
+//    which may be overwritten, so that fixed bit coding outputs whole groups of values.
+// return number of bytes output or negative value if error
+{
+    return td64dInternal(inVals, outVals, nOriginalValues, bytesProcessed, 1);
+} // end td64d_slack
@@ -27,7 +27,7 @@
 #define NDEBUG // disable asserts
 #include <assert.h>
 
-#define TD64_VERSION "v2.1.8"
+#define TD64_VERSION "v2.2.26"
 #define MAX_TD64_BYTES 64  // max input vals supported
 #define MIN_TD64_BYTES 1  // min input vals supported
 #define MAX_UNIQUES 16 // max uniques supported in input
@@ -36,13 +36,55 @@
 #define MIN_STRING_MODE_UNIQUES 17 // string mode stores unique count excess 16
 #define MIN_VALUES_7_BIT_MODE 16
 #define MIN_VALUE_7_BIT_MODE_12_PERCENT 24 // min value where 7-bit mode expected to approach 12%, otherwise 6%
+#define TD64_SHARED_UNIQUES_MODE 0x6f // first byte for fixed bit coding with uniques stored once by td512
+#define TD64_PRIMED_STRING_MODE 0x8f // first byte for extended string mode primed with a td512 dictionary
+#define TD64_TRAINED_TEXT_MODE 0x37 // first byte for text mode with a registered table, followed by the table id
+#define TD64_MAX_TEXT_TABLES 16 // table ids 0 to 15 for td64RegisterTextTable
+#define TD64_TEXT_TABLE_CHARS 23 // characters in a text table, most frequent first
+#define TD64_TEXT_BIGRAMS 16 // bigrams registered for a text table with td64RegisterTextBigrams, most frequent first
+#define TD64_BIGRAM_TEXT_MODE 0x47 // first byte for text mode with one code for each of 16 frequent bigrams
+#define TD64_TRAINED_BIGRAM_MODE 0x57 // first byte for bigram text mode with a registered table and bigrams, followed by the table id
+#define TD64_DELTA_MODE 0x0f // first byte for td64 of the delta or XOR of values 1 to 8 bytes apart
+#define TD64_DELTA_XOR 0x10 // bit in the byte following TD64_DELTA_MODE for XOR rather than delta
+#define MIN_VALUES_DELTA_MODE 16
+#define TD64_FOR_U32_MODE 0x1f // first byte for frame-of-reference coding of 32-bit integers by td512_u32
+#define TD64_FOR_U64_MODE 0x2f // first byte for frame-of-reference coding of 64-bit integers by td512_u64
+#define TD64_XOR_F64_MODE 0x3f // first byte for the XOR of consecutive doubles by td512_f64
+#define TD64_DOD_U64_MODE 0x4f // first byte for the delta of delta of timestamps by td512_ts64
+#define TD64_NUMERIC_TEXT_MODE 0x5f // first byte for 4-bit codes of digits, . - , : and one other value
+#define TD64_NUMERIC_TEXT_CODES 16
+#define TD64_HEX_MODE 0x9f // first byte for 4 bits per hex character
+#define TD64_BASE64_MODE 0xaf // first byte for 6 bits per base64 character
+#define TD64_NIBBLE_MODE 0xbf // first byte for separate codes of the high and low nibble of each value
+#define TD64D_OUTPUT_SLACK 8 // bytes past the values that td64d_slack and td512d_slack may overwrite
 //#define TD64_TEST_MODE // enable this macro to collect some statistics with variables g_td64...
 
 int32_t td5(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues);
 int32_t td5d(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+uint32_t td5Bits(const unsigned char *inVals, const uint32_t nOriginalValues);
 int32_t td64(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues);
 int32_t td64d(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
-int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes);
+int32_t td64d_slack(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+int32_t td64_estimate(const unsigned char *inVals, const uint32_t nValues);
+int32_t td64_table(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId);
+int32_t encodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes, const int32_t tableId);
+int32_t adaptiveTextModeBits(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const unsigned char *val256, const uint32_t predefinedTextCharCnt, const uint32_t highBitclear, const uint32_t maxBytes, const int32_t tableId);
 int32_t decodeAdaptiveTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+int32_t td64RegisterTextTable(const uint32_t tableId, const unsigned char *textChars);
+int32_t td64RegisterTextBigrams(const uint32_t tableId, const unsigned char *bigrams);
+int32_t td64CheckTextTable(const int32_t tableId);
+const uint32_t *td64TextCharBits(const int32_t tableId);
+int32_t encodeSharedUniquesMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t *sharedOccurrence, const uint32_t nSharedUniques, uint32_t *uniquesUsed);
+int32_t sharedUniquesModeBits(const unsigned char *inVals, const uint32_t nValues, const uint32_t *sharedOccurrence, const uint32_t nSharedUniques, uint32_t *uniquesUsed);
+uint32_t countNumericTextChars(const unsigned char *inVals, const uint32_t nValues);
+int32_t encodeNumericTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t maxBits);
+int32_t numericTextModeBits(const unsigned char *inVals, const uint32_t nValues, const uint32_t maxBits);
+int32_t decodeNumericTextMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+uint32_t checkAlphabetMode(const unsigned char *inVals, const uint32_t nValues);
+int32_t encodeAlphabetMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const uint32_t flags);
+int32_t alphabetModeBits(const unsigned char *inVals, const uint32_t nValues, const uint32_t flags);
+int32_t decodeAlphabetMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+int32_t decodeDeltaMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+int32_t decodeSharedUniquesMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, const unsigned char *sharedUniques, const uint32_t nSharedUniques, uint32_t *bytesProcessed);
 
 #endif /* td64_h */
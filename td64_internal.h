@@ -23,8 +23,30 @@
 #ifndef td64_internal_h
 #define td64_internal_h
 
+#include "td64.h"
+
 #define MIN_STRING_MODE_EXTENDED_VALUES 16
 
+// analysis of a block of values done by a caller of td64Analyzed, such as checktd64 in td512.c
+// counts and uniques are for all nValues; the InitLoop members are for the first nValsInitLoop
+// values used by td64 for its random data and text mode checks (28 for 64 values)
+typedef struct
+{
+    uint8_t val256[256]; // occurrence count of each value
+    uint32_t uniqueOccurrence[256]; // order of first occurrence for each unique
+    unsigned char uniques[MAX_TD64_BYTES]; // uniques in order of first occurrence
+    uint32_t nUniqueVals;
+    uint32_t nUniqueValsInitLoop;
+    uint32_t highBitCheckInitLoop; // OR of values in init loop
+    uint32_t highBitCheck; // OR of all values
+    uint32_t predefinedTextCharCnt; // predefinedBitTextChars count in init loop
+    int32_t singleValue; // first value to reach single value mode repeats, else -1
+    int32_t tableId; // registered text table whose characters are counted, else -1 for the predefined tables
+} td64Analysis;
+
+int32_t td64Analyzed(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const td64Analysis *analysis);
+int32_t td64TableSized(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues, const int32_t tableId, const uint32_t sizeOnly);
+
 static const uint32_t encodingBits[64]={1,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6};
 static const uint32_t bitMask[]={0,1,3,7,15,31,63,127,255,511};
 
@@ -72,7 +94,35 @@ static inline void thisOutIx2(unsigned char *outValsT, const uint32_t nBits, con
     }
 } // end thisOutIx2
 
-static int32_t encode7bitsInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
+static inline void thisOutIx2Sized(unsigned char *outValsT, const uint32_t nBits, const uint64_t bitVal, uint32_t *thisOutIx, uint32_t *nextOutBit, uint64_t *outBits, const uint32_t sizeOnly)
+{
+    // thisOutIx2, or when sizeOnly is set advance thisOutIx and nextOutBit the same way without output
+    if (!sizeOnly)
+    {
+        thisOutIx2(outValsT, nBits, bitVal, thisOutIx, nextOutBit, outBits);
+        return;
+    }
+    *nextOutBit += nBits;
+    if (*nextOutBit >= 64)
+    {
+        *thisOutIx += 8;
+        *nextOutBit -= 64;
+    }
+} // end thisOutIx2Sized
+
+static inline void esmOutputRemainderSized(unsigned char *outValsT, uint32_t *thisOutIx, uint32_t *nextOutBit, uint64_t *outBits, const uint32_t sizeOnly)
+{
+    // esmOutputRemainder, or when sizeOnly is set advance thisOutIx past the remaining bits without output
+    if (!sizeOnly)
+    {
+        esmOutputRemainder(outValsT, thisOutIx, nextOutBit, outBits);
+        return;
+    }
+    *thisOutIx += (*nextOutBit + 7) / 8;
+    *nextOutBit = 0;
+} // end esmOutputRemainderSized
+
+static inline int32_t encode7bitsInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValues)
 {
     // for internal use: output 7 bytes for each 8-byte group, then remaining bytes
     uint32_t nextOutVal=0;
@@ -129,7 +179,7 @@ static int32_t encode7bitsInternal(const unsigned char *inVals, unsigned char *o
     return (int32_t)nextOutVal;
 } // end encode7bitsInternal
 
-static int32_t decode7bitsInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+static inline int32_t decode7bitsInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
 {
     // decode values directly into outVals
     uint32_t nextOutVal=0;
@@ -0,0 +1,240 @@
+//
+//  tdKeys.c
+//  Front coding of batches of sorted keys, such as those of B-tree leaf pages
+//  and SSTable index blocks, with restart points for random access.
+//
+//  Copyright © 2021-2022 L. Stevan Leonard. All rights reserved.
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tdKeys.h"
+#include "td512.h"
+#include <string.h>
+
+#define KEYS_HEADER_BYTES 3 // number of keys and restart interval
+#define KEYS_RESTART_OFFSET_BYTES 4
+
+static inline uint32_t keysRestartOffset(const unsigned char *inVals, const uint32_t restartIx)
+{
+    // offset from inVals of the group of keys for restartIx
+    const unsigned char *pOffset=inVals + KEYS_HEADER_BYTES + restartIx*KEYS_RESTART_OFFSET_BYTES;
+    return pOffset[0] | (uint32_t)pOffset[1] << 8 | (uint32_t)pOffset[2] << 16 | (uint32_t)pOffset[3] << 24;
+} // end keysRestartOffset
+
+static int32_t keysOutputTd512(const unsigned char *vals, const uint32_t nVals, unsigned char *outVals, uint32_t *outputOffset, const uint32_t maxOutBytes)
+{
+    // td512 of nVals values when the output fits in outVals
+    int32_t retBytes;
+    if (*outputOffset >= maxOutBytes)
+        return -143; // output buffer too small
+    if ((retBytes=td512_max(vals, outVals + *outputOffset, nVals, maxOutBytes - *outputOffset)) < 0)
+        return retBytes == -151 ? -143 : retBytes; // -143 for output buffer too small
+    *outputOffset += (uint32_t)retBytes;
+    return retBytes;
+} // end keysOutputTd512
+
+int32_t tdKeysEncode(const unsigned char *keyVals, const uint32_t *keySizes, const uint32_t nKeys, const uint32_t restartInterval, unsigned char *outVals, const uint32_t maxOutBytes)
+{
+    // keyVals holds nKeys sorted keys one after the other, with sizes in keySizes
+    // each key is coded as the length of the prefix it shares with the previous key and the suffix that follows,
+    // except that the first key of every restartInterval keys is coded whole so that tdKeysGet can start there
+    // output: number of keys (2 bytes), restartInterval and the offset of each group of restartInterval keys (4 bytes),
+    // then for each group, td512 of the shared lengths followed by the suffix lengths, and td512 of the suffixes
+    // in blocks of up to 512 values
+    // returns the number of bytes output
+    const unsigned char *thisKey=keyVals;
+    uint32_t prevKeySize=0;
+    uint32_t outputOffset;
+    uint32_t keyIx=0;
+    uint32_t restartIx=0;
+    int32_t retBytes;
+
+    if (nKeys == 0 || nKeys > TDKEYS_MAX_KEYS || restartInterval == 0 || restartInterval > TDKEYS_MAX_RESTART_INTERVAL)
+        return -141;
+    const uint32_t nRestarts=(nKeys + restartInterval - 1) / restartInterval;
+    outputOffset = KEYS_HEADER_BYTES + nRestarts*KEYS_RESTART_OFFSET_BYTES;
+    if (outputOffset > maxOutBytes)
+        return -143; // output buffer too small
+    outVals[0] = (unsigned char)nKeys;
+    outVals[1] = (unsigned char)(nKeys >> 8);
+    outVals[2] = (unsigned char)restartInterval;
+    while (keyIx < nKeys)
+    {
+        const uint32_t nGroupKeys=nKeys-keyIx < restartInterval ? nKeys-keyIx : restartInterval;
+        unsigned char *pOffset=outVals + KEYS_HEADER_BYTES + restartIx*KEYS_RESTART_OFFSET_BYTES;
+        unsigned char lengths[TDKEYS_MAX_RESTART_INTERVAL*2];
+        unsigned char suffixVals[512];
+        uint32_t nSuffixVals=0;
+        const unsigned char *groupKey=thisKey;
+        uint32_t i;
+        pOffset[0] = (unsigned char)outputOffset;
+        pOffset[1] = (unsigned char)(outputOffset >> 8);
+        pOffset[2] = (unsigned char)(outputOffset >> 16);
+        pOffset[3] = (unsigned char)(outputOffset >> 24);
+        for (i=0; i<nGroupKeys; i++)
+        {
+            // shared lengths in the first half of lengths and suffix lengths in the second half
+            const uint32_t keySize=keySizes[keyIx+i];
+            uint32_t nShared=0;
+            if (keySize > TDKEYS_MAX_KEY_BYTES)
+                return -142;
+            if (i > 0)
+            {
+                const unsigned char *prevKey=thisKey-prevKeySize;
+                const uint32_t maxShared=keySize < prevKeySize ? keySize : prevKeySize;
+                while (nShared < maxShared && thisKey[nShared] == prevKey[nShared])
+                    nShared++;
+            }
+            lengths[i] = (unsigned char)nShared;
+            lengths[nGroupKeys+i] = (unsigned char)(keySize - nShared);
+            thisKey += keySize;
+            prevKeySize = keySize;
+        }
+        if ((retBytes=keysOutputTd512(lengths, nGroupKeys*2, outVals, &outputOffset, maxOutBytes)) < 0)
+            return retBytes;
+        for (i=0; i<nGroupKeys; i++)
+        {
+            // suffixes of the group one after the other
+            const unsigned char *suffix=groupKey + lengths[i];
+            uint32_t nSuffixRemaining=lengths[nGroupKeys+i];
+            while (nSuffixRemaining > 0)
+            {
+                const uint32_t nCopyVals=nSuffixRemaining < 512-nSuffixVals ? nSuffixRemaining : 512-nSuffixVals;
+                memcpy(suffixVals+nSuffixVals, suffix, nCopyVals);
+                nSuffixVals += nCopyVals;
+                suffix += nCopyVals;
+                nSuffixRemaining -= nCopyVals;
+                if (nSuffixVals == 512)
+                {
+                    if ((retBytes=keysOutputTd512(suffixVals, nSuffixVals, outVals, &outputOffset, maxOutBytes)) < 0)
+                        return retBytes;
+                    nSuffixVals = 0;
+                }
+            }
+            groupKey += lengths[i] + lengths[nGroupKeys+i];
+        }
+        if (nSuffixVals > 0 && (retBytes=keysOutputTd512(suffixVals, nSuffixVals, outVals, &outputOffset, maxOutBytes)) < 0)
+            return retBytes;
+        keyIx += nGroupKeys;
+        restartIx++;
+    }
+    return (int32_t)outputOffset;
+} // end tdKeysEncode
+
+static int32_t keysDecodeGroup(const unsigned char *inVals, uint32_t inputOffset, const uint32_t nGroupKeys, const uint32_t nDecodeKeys, unsigned char *keyVals, const uint32_t maxKeyVals, uint32_t *keySizes)
+{
+    // decode the first nDecodeKeys keys of the group of nGroupKeys keys at inputOffset
+    // when keySizes is NULL, each key is decoded over the previous one, whose shared prefix is already in place,
+    // and the size of the last key is returned
+    // otherwise keys are output one after the other and the number of values output is returned
+    unsigned char lengths[512]; // room for the values of any td512 block
+    unsigned char suffixVals[512];
+    uint32_t nSuffixVals=0;
+    uint32_t suffixPos=0;
+    uint32_t keyPos=0;
+    uint32_t prevKeySize=0;
+    uint32_t bytesProcessed;
+    int32_t retVals;
+    uint32_t i;
+
+    if ((retVals=td512d(inVals+inputOffset, lengths, &bytesProcessed)) < 0)
+        return retVals;
+    if ((uint32_t)retVals != nGroupKeys*2 || lengths[0] != 0)
+        return -144; // corrupt keys data
+    inputOffset += bytesProcessed;
+    for (i=0; i<nDecodeKeys; i++)
+    {
+        const uint32_t nShared=lengths[i];
+        uint32_t nSuffixRemaining=lengths[nGroupKeys+i];
+        unsigned char *thisKey=keyVals;
+        if (nShared > prevKeySize || nShared + nSuffixRemaining > TDKEYS_MAX_KEY_BYTES)
+            return -144; // corrupt keys data
+        if (keySizes != NULL)
+        {
+            thisKey += keyPos;
+            if (keyPos + nShared + nSuffixRemaining > maxKeyVals)
+                return -145; // keyVals too small
+            memcpy(thisKey, thisKey-prevKeySize, nShared);
+            keySizes[i] = nShared + nSuffixRemaining;
+        }
+        prevKeySize = nShared + nSuffixRemaining;
+        keyPos += prevKeySize;
+        thisKey += nShared;
+        while (nSuffixRemaining > 0)
+        {
+            uint32_t nCopyVals;
+            if (suffixPos == nSuffixVals)
+            {
+                // next block of suffixes
+                if ((retVals=td512d(inVals+inputOffset, suffixVals, &bytesProcessed)) <= 0)
+                    return retVals < 0 ? retVals : -144;
+                inputOffset += bytesProcessed;
+                nSuffixVals = (uint32_t)retVals;
+                suffixPos = 0;
+            }
+            nCopyVals = nSuffixRemaining < nSuffixVals-suffixPos ? nSuffixRemaining : nSuffixVals-suffixPos;
+            memcpy(thisKey, suffixVals+suffixPos, nCopyVals);
+            thisKey += nCopyVals;
+            suffixPos += nCopyVals;
+            nSuffixRemaining -= nCopyVals;
+        }
+    }
+    return (int32_t)(keySizes != NULL ? keyPos : prevKeySize);
+} // end keysDecodeGroup
+
+int32_t tdKeysDecode(const unsigned char *inVals, unsigned char *keyVals, const uint32_t maxKeyVals, uint32_t *keySizes, const uint32_t maxKeys)
+{
+    // decode all keys encoded by tdKeysEncode one after the other into keyVals, with their sizes in keySizes
+    // the number of keys is in the first two bytes of inVals
+    // returns the number of keys
+    const uint32_t nKeys=inVals[0] | (uint32_t)inVals[1] << 8;
+    const uint32_t restartInterval=inVals[2];
+    uint32_t nKeyVals=0;
+    uint32_t keyIx=0;
+    uint32_t restartIx=0;
+    int32_t retVals;
+
+    if (nKeys == 0 || restartInterval == 0 || restartInterval > TDKEYS_MAX_RESTART_INTERVAL)
+        return -144; // corrupt keys data
+    if (nKeys > maxKeys)
+        return -145; // keySizes too small
+    while (keyIx < nKeys)
+    {
+        const uint32_t nGroupKeys=nKeys-keyIx < restartInterval ? nKeys-keyIx : restartInterval;
+        if ((retVals=keysDecodeGroup(inVals, keysRestartOffset(inVals, restartIx), nGroupKeys, nGroupKeys, keyVals+nKeyVals, maxKeyVals-nKeyVals, keySizes+keyIx)) < 0)
+            return retVals;
+        nKeyVals += (uint32_t)retVals;
+        keyIx += nGroupKeys;
+        restartIx++;
+    }
+    return (int32_t)nKeys;
+} // end tdKeysDecode
+
+int32_t tdKeysGet(const unsigned char *inVals, const uint32_t keyIx, unsigned char *keyVal)
+{
+    // decode the key at keyIx from its restart point into keyVal, which holds TDKEYS_MAX_KEY_BYTES
+    // returns the size of the key
+    const uint32_t nKeys=inVals[0] | (uint32_t)inVals[1] << 8;
+    const uint32_t restartInterval=inVals[2];
+
+    if (restartInterval == 0 || restartInterval > TDKEYS_MAX_RESTART_INTERVAL)
+        return -144; // corrupt keys data
+    if (keyIx >= nKeys)
+        return -146; // no key at keyIx
+    const uint32_t restartIx=keyIx / restartInterval;
+    const uint32_t groupKeyIx=restartIx * restartInterval;
+    const uint32_t nGroupKeys=nKeys-groupKeyIx < restartInterval ? nKeys-groupKeyIx : restartInterval;
+    return keysDecodeGroup(inVals, keysRestartOffset(inVals, restartIx), nGroupKeys, keyIx-groupKeyIx+1, keyVal, TDKEYS_MAX_KEY_BYTES, NULL);
+} // end tdKeysGet
@@ -0,0 +1,36 @@
+//
+//  tdKeys.h
+//  td512
+//
+//  Front coding of batches of sorted keys.
+//
+//  Copyright © 2021-2022 L. Stevan Leonard. All rights reserved.
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef tdKeys_h
+#define tdKeys_h
+
+#include <stdint.h>
+
+#define TDKEYS_MAX_KEYS 65535 // keys in one batch
+#define TDKEYS_MAX_KEY_BYTES 255 // bytes in one key
+#define TDKEYS_MAX_RESTART_INTERVAL 128 // keys front coded from each restart point
+
+int32_t tdKeysEncode(const unsigned char *keyVals, const uint32_t *keySizes, const uint32_t nKeys, const uint32_t restartInterval, unsigned char *outVals, const uint32_t maxOutBytes);
+int32_t tdKeysDecode(const unsigned char *inVals, unsigned char *keyVals, const uint32_t maxKeyVals, uint32_t *keySizes, const uint32_t maxKeys);
+int32_t tdKeysGet(const unsigned char *inVals, const uint32_t keyIx, unsigned char *keyVal);
+
+#endif /* tdKeys_h */
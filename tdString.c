@@ -26,12 +26,34 @@
 
 #define MAX_STRING_MODE_EXTENDED_VALUES 512
 
-int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut)
+static inline uint32_t esmPositionBits(const uint32_t pos)
+{
+    // bits to encode a string position below pos, which exceeds 511 only
+    // when prime values precede the values to encode
+    if (pos < MAX_STRING_MODE_EXTENDED_VALUES)
+        return encodingBits512[pos];
+    if (pos < 1024)
+        return 10;
+    if (pos < 2048)
+        return 11;
+    if (pos < 4096)
+        return 12;
+    return 13;
+} // end esmPositionBits
+
+static inline int32_t encodeExtendedStringModeInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut, const uint32_t nPrimeVals, const unsigned char *primeUniques, const uint32_t nPrimeUniques, const uint32_t maxBytes, const uint32_t sizeOnly)
 {
-    // Encode repeated strings and values in input until the 65th unique value,
+    // Encode repeated strings and values in input until the 129th unique value,
     // then conclude processing and return the number of values.
     // If the number of encoded values exceeds the number of input values,
     // return 0.
+    // When nPrimeVals > 0, the first nPrimeVals of inVals are a dictionary
+    // that is not output: its uniques (primeUniques, first occurrence order)
+    // and pairs are known to the decoder, and strings may be taken from it.
+    // Return -102 once the output does not fit in maxBytes, checked at each
+    // new unique and at the end; nothing is written past maxBytes.
+    // When sizeOnly is set, return the same bits without output of the
+    // encoding, with only the uniques and info bytes written to outVals.
     uint32_t inPos; // current position in inVals
     uint32_t inVal;
     uint32_t nUniques; // first value is always a unique
@@ -47,70 +69,106 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
     uint32_t highBitClear;
     uint64_t outBits; // accumulate 64 bits before output
     uint32_t nUniqueBitsPlus2=3; // bits to encode current number of uniques (1 or 2) plus 2 control bits
-    uint32_t nextInVal=inVals[2];
+    uint32_t nextInVal=inVals[nPrimeVals+2];
     
-    if (nValuesMax > MAX_STRING_MODE_EXTENDED_VALUES || nValuesMax < MIN_STRING_MODE_EXTENDED_VALUES)
+    if (nValuesMax-nPrimeVals > MAX_STRING_MODE_EXTENDED_VALUES || nPrimeVals > MAX_STRING_MODE_PRIME_VALUES || nValuesMax-nPrimeVals < MIN_STRING_MODE_EXTENDED_VALUES)
         return -100;
+    if (maxBytes < 4)
+        return -102; // no room for the info bytes and first two values
     outVals[1] = 0; // init second info byte
     thisOutIx = 0; // start of encoding in outValsT
-    // output encoding of first two values in outVals starting at third bit in second byte
-    //    first bit is last bit of unique count, second is whether
-    //    uniques are compressed
-    inVal=inVals[0];
-    highBitClear = inVal;
-    outVals[2] = inVal;
-    if (inVal == inVals[1])
+    if (nPrimeVals > 0)
     {
-        // first two values are the same
-        nUniques = 1;
-        val256[inVal] = 1; // indicate encountered
-        uniqueOccurrence[inVal] = 0;
-        twoVals[0] = 1;  // 1 << next unique val
-        twoValsPoss[0] = 2; // set position (0,0): unique << 6 | next unique, to pos first unique + 2
-        if (inVal != inVals[2])
+        // set up uniques and pairs from the dictionary values, then start
+        // encoding at the first input value
+        uint32_t i;
+        for (i=0; i<nPrimeUniques; i++)
         {
-            // set up for new unique in third position
-            twoVals[0] |= 2; // (0,1)
-            twoValsPoss[1] = 3; // set position to two past second value
+            val256[primeUniques[i]] = 1;
+            uniqueOccurrence[primeUniques[i]] = i;
+            twoVals[i] = 0;
+        }
+        for (i=0; i<nPrimeVals; i++)
+        {
+            const uint32_t firstVal=inVals[i];
+            const uint32_t secondVal=inVals[i+1];
+            if (val256[firstVal] && val256[secondVal])
+            {
+                const uint32_t UOfirst=uniqueOccurrence[firstVal];
+                const uint32_t UOsecond=uniqueOccurrence[secondVal];
+                twoVals[UOfirst] |= 1llu << UOsecond;
+                twoValsPoss[(UOfirst<<6) | UOsecond] = i + 2;
+            }
         }
-        // output 1 to indicate first unique value repeated
-        outBits = 1; // 1 for first encoding bit
+        nUniques = nPrimeUniques;
+        nUniqueBitsPlus2 = encodingBits512[nPrimeUniques-1]+2;
+        highBitClear = 0;
+        outBits = 0;
+        nextOutBit = 0;
+        inPos = nPrimeVals;
+        nextInVal = inVals[nPrimeVals];
     }
     else
     {
-        // second val is a new unique
-        // set twoValsPos for first position (0,1)
-        nUniques = 2;
-        val256[inVal] = 1;
-        uniqueOccurrence[inVal] = 0;
-        inVal = inVals[1]; // inVal is now second value
-        highBitClear |= inVal;
-        outVals[3] = inVal;
-        val256[inVal] = 1;
-        uniqueOccurrence[inVal] = 1;
-        twoVals[0] = 2; // 1 << next unique val
-        twoValsPoss[1] = 2; // set position (0,1): unique << 6 | next unique, to pos first unique + 2
-        inVal = inVals[2]; // inval is now value in third position
-        uint32_t UOinPos2=uniqueOccurrence[inVal];
-        if (val256[inVal] == 0)
+        // output encoding of first two values in outVals starting at third bit in second byte
+        //    first bit is last bit of unique count, second is whether
+        //    uniques are compressed
+        inVal=inVals[0];
+        highBitClear = inVal;
+        outVals[2] = inVal;
+        if (inVal == inVals[1])
+        {
+            // first two values are the same
+            nUniques = 1;
+            val256[inVal] = 1; // indicate encountered
+            uniqueOccurrence[inVal] = 0;
+            twoVals[0] = 1;  // 1 << next unique val
+            twoValsPoss[0] = 2; // set position (0,0): unique << 6 | next unique, to pos first unique + 2
+            if (inVal != inVals[2])
+            {
+                // set up for new unique in third position
+                twoVals[0] |= 2; // (0,1)
+                twoValsPoss[1] = 3; // set position to two past second value
+            }
+            // output 1 to indicate first unique value repeated
+            outBits = 1; // 1 for first encoding bit
+        }
+        else
         {
-            // new unique in third position
-            UOinPos2 = 2;
+            // second val is a new unique
+            // set twoValsPos for first position (0,1)
+            nUniques = 2;
+            val256[inVal] = 1;
+            uniqueOccurrence[inVal] = 0;
+            inVal = inVals[1]; // inVal is now second value
+            highBitClear |= inVal;
+            outVals[3] = inVal;
+            val256[inVal] = 1;
+            uniqueOccurrence[inVal] = 1;
+            twoVals[0] = 2; // 1 << next unique val
+            twoValsPoss[1] = 2; // set position (0,1): unique << 6 | next unique, to pos first unique + 2
+            inVal = inVals[2]; // inval is now value in third position
+            uint32_t UOinPos2=uniqueOccurrence[inVal];
+            if (val256[inVal] == 0)
+            {
+                // new unique in third position
+                UOinPos2 = 2;
+            }
+            // set up new two value in 2nd position
+            twoVals[1] = 1 << UOinPos2;
+            twoValsPoss[64 | UOinPos2] = 3; // set position to two past second value
+            outBits = 0; // for first encoding bit
         }
-        // set up new two value in 2nd position
-        twoVals[1] = 1 << UOinPos2;
-        twoValsPoss[64 | UOinPos2] = 3; // set position to two past second value
-        outBits = 0; // for first encoding bit
+        inPos=2; // start loop after init of first two values
     }
     // smaller values compress slightly better with string limit of 9 versus 17
     const uint32_t string_limit=nValuesMax<=64 ? 9 : 17;
     const uint32_t extended_string_length_bits=nValuesMax<=64 ? 3 : 4;
     const uint32_t stringBits=2+extended_string_length_bits;
     const uint32_t stringEndPos=nValuesMax-string_limit+3; // used with inPos+4 to end one before last value
-    const uint32_t maxCompressedPos=nValuesMax-nValuesMax/16;
+    const uint32_t maxCompressedPos=(nValuesMax-nPrimeVals)-(nValuesMax-nPrimeVals)/16;
     const uint32_t lastPos=nValuesMax-1;
     
-    inPos=2; // start loop after init of first two values
     while (inPos < lastPos)
     {
         inVal = nextInVal; // set this val already retrieved value
@@ -119,12 +177,14 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
         {
             // set up for new unique in this position
             // uniques > 64 are output as uniques but are not considered for processing
-            if (thisOutIx+nUniques > maxCompressedPos)
+            if (thisOutIx+nUniques-nPrimeUniques > maxCompressedPos)
             {
                 // getting less than 6% compression: fail
-                *nValuesOut = inPos - 1; // processed through last inPos
+                *nValuesOut = inPos - 1 - nPrimeVals; // processed through last inPos
                 return 0;
             }
+            if (thisOutIx+nUniques-nPrimeUniques+3 > maxBytes)
+                return -102; // info bytes, uniques with this one, and encoding do not fit
             if (nUniques < MAX_UNIQUES_EXTENDED_STRING_MODE)
             {
                 uint32_t UOinValsInPosP1;
@@ -165,11 +225,14 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
             if (++nextOutBit == 64)
             {
                 // output outBits and init for next output
-                esmOutputOutBits(outValsT, &thisOutIx, &outBits);
+                if (sizeOnly)
+                    thisOutIx += 8;
+                else
+                    esmOutputOutBits(outValsT, &thisOutIx, &outBits);
                 outBits = 0;
                 nextOutBit = 0;
             }
-            outVals[nUniques+1] = (unsigned char)inVal; // save unique or any value encountered beyond 64 uniques in list at front of outVals starting in third position
+            outVals[nUniques+1-nPrimeUniques] = (unsigned char)inVal; // save unique or any value encountered beyond 64 uniques in list at front of outVals starting in third position
             continue;
         }
         // this character occurred before: look for repetition of next character
@@ -185,7 +248,7 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
                 twoValsPoss[(UOinVal<<6) | UOinValsInPosP1] = inPos + 1;
             }
             // output repeated value: 01 plus unique occurrence
-            thisOutIx2(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
             continue;
         }
         const uint64_t TVuniqueOccurrence=twoVals[UOinVal];
@@ -200,15 +263,24 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
             {
                 // two vals + 2 include first value so overlap with second to fourth values; only check once for strings from 2 to 4
                 // output repeated value: 01 plus unique occurrence
-                thisOutIx2(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits);
+                thisOutIx2Sized(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
                 continue;
             }
             const unsigned char *matchPos=inVals+twoValsPos;
             if (inVals[++inPos] != *matchPos++) // three-character match?
             {
+                const uint32_t posBits=esmPositionBits(inPos-2);
+                if (posBits > 9 && stringBits+posBits > 2*nUniqueBitsPlus2)
+                {
+                    // positions into a long window cost more than two repeated values:
+                    // output a repeated value and continue from the second value
+                    thisOutIx2Sized(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
+                    nextInVal = inVals[--inPos];
+                    continue;
+                }
                 // no, output two-character string
                 // output 11 plus string length bit then position of string
-                thisOutIx2(outValsT, stringBits+encodingBits512[inPos-2], (3 | ((twoValsPos-2)<<stringBits)), &thisOutIx, &nextOutBit, &outBits);
+                thisOutIx2Sized(outValsT, stringBits+posBits, (3 | ((twoValsPos-2)<<stringBits)), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
                 nextInVal = inVals[inPos];
                 continue;
             }
@@ -216,7 +288,7 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
             {
                 // no, output three-character string
                 // output 11 plus string length bit then position of string
-                thisOutIx2(outValsT, stringBits+encodingBits512[inPos-3], (7 | ((twoValsPos-2)<<stringBits)), &thisOutIx, &nextOutBit, &outBits);
+                thisOutIx2Sized(outValsT, stringBits+esmPositionBits(inPos-3), (7 | ((twoValsPos-2)<<stringBits)), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
                 nextInVal = inVals[inPos];
                 continue;
             }
@@ -237,7 +309,7 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
             assert(twoValsPos+strCount<=inPos-1);
             // output 11 plus string length bit then position of string
             // strCount is 1 greater than its actual length and the output length is 1 less than actual length
-            thisOutIx2(outValsT, stringBits+encodingBits512[inPos+1-strCount], (3 | ((strCount-3)<<2)) | ((twoValsPos-2)<<stringBits), &thisOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outValsT, stringBits+esmPositionBits(inPos+1-strCount), (3 | ((strCount-3)<<2)) | ((twoValsPos-2)<<stringBits), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
             nextInVal = inVals[inPos];
         }
         else
@@ -247,7 +319,7 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
             twoVals[UOinVal] |= 1llu << UOinValsInPosP1;
             twoValsPoss[(UOinVal<<6) | UOinValsInPosP1] = inPos + 1;
             // output repeated value: 01 plus unique occurrence
-            thisOutIx2(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outValsT, nUniqueBitsPlus2, (uint64_t)(1|(UOinVal<<2)), &thisOutIx, &nextOutBit, &outBits, sizeOnly);
         }
     }
     // output final bits
@@ -255,23 +327,24 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
     {
         // occurs for both end of input on last pos -1 and for max uniques exceeded
         if (maxUniquesExceeded)
-            thisOutIx2(outValsT, 8, (uint64_t)inVals[maxUniquesExceeded-1], &thisOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outValsT, 8, (uint64_t)inVals[maxUniquesExceeded-1], &thisOutIx, &nextOutBit, &outBits, sizeOnly);
         else
-            thisOutIx2(outValsT, 8, (uint64_t)inVals[lastPos], &thisOutIx, &nextOutBit, &outBits);
+            thisOutIx2Sized(outValsT, 8, (uint64_t)inVals[lastPos], &thisOutIx, &nextOutBit, &outBits, sizeOnly);
     }
     if (nextOutBit > 0)
     {
-        esmOutputRemainder(outValsT, &thisOutIx, &nextOutBit, &outBits); // index past final bits
+        esmOutputRemainderSized(outValsT, &thisOutIx, &nextOutBit, &outBits, sizeOnly); // index past final bits
     }
-    *nValuesOut = maxUniquesExceeded ? maxUniquesExceeded : nValuesMax;
-    if (thisOutIx + nUniques > *nValuesOut - 1)
+    *nValuesOut = (maxUniquesExceeded ? maxUniquesExceeded : nValuesMax) - nPrimeVals;
+    const uint32_t nOutUniques=nUniques-nPrimeUniques;
+    if (thisOutIx + nOutUniques > *nValuesOut - 1)
         return 0;
     // use 7-bit encoding on uniques if all high bits set
     int32_t uniqueOffset;
     if ((highBitClear & 0x80) == 0 && *nValuesOut >= 16)
     {
         unsigned char compressedUniques[MAX_TOTAL_UNIQUES_EXTENDED_STRING_MODE];
-        uniqueOffset = encode7bitsInternal(outVals+2, compressedUniques, nUniques);
+        uniqueOffset = encode7bitsInternal(outVals+2, compressedUniques, nOutUniques);
         if (uniqueOffset > 0)
         {
             outVals[1] |= 128;
@@ -281,19 +354,45 @@ int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
         else
         {
             // uniques did not compress
-            uniqueOffset = nUniques + 2;
+            uniqueOffset = nOutUniques + 2;
         }
     }
     else
     {
-        uniqueOffset = nUniques + 2;
+        uniqueOffset = nOutUniques + 2;
     }
-    memcpy(outVals+uniqueOffset, outValsT, thisOutIx);
-    outVals[0] = 0x7f; // indicate external string mode
+    if (thisOutIx + (uint32_t)uniqueOffset > maxBytes)
+        return -102;
+    if (!sizeOnly)
+        memcpy(outVals+uniqueOffset, outValsT, thisOutIx);
+    outVals[0] = nPrimeVals ? TD64_PRIMED_STRING_MODE : 0x7f; // indicate external string mode
     outVals[1] |= nUniques-1; // number uniques in first 7 bits then compressed uniques bit
     return (int32_t)(thisOutIx+uniqueOffset) * 8;
+} // end encodeExtendedStringModeInternal
+
+int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut)
+{
+    // without a bound: the checks of maxBytes never fail for nValuesMax+3 as the encoding is less than nValuesMax bytes
+    return encodeExtendedStringModeInternal(inVals, outVals, nValuesMax, nValuesOut, 0, NULL, 0, nValuesMax+3, 0);
 } // end encodeExtendedStringMode
 
+int32_t encodeExtendedStringModeMax(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut, const uint32_t maxBytes, const uint32_t sizeOnly)
+{
+    // same as encodeExtendedStringMode with output of at most maxBytes, else -102
+    // when sizeOnly is set, returns the bits without output of the encoding
+    return encodeExtendedStringModeInternal(inVals, outVals, nValuesMax, nValuesOut, 0, NULL, 0, maxBytes, sizeOnly);
+} // end encodeExtendedStringModeMax
+
+int32_t encodeExtendedStringModePrimed(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut, const uint32_t nPrimeVals, const unsigned char *primeUniques, const uint32_t nPrimeUniques, const uint32_t maxBytes)
+{
+    // inVals holds nPrimeVals dictionary values followed by the values to
+    // encode, for nValuesMax total; nValuesOut excludes the dictionary values
+    // output is at most maxBytes, else -102
+    if (nPrimeVals == 0 || nPrimeVals >= nValuesMax || nPrimeUniques == 0 || nPrimeUniques > MAX_UNIQUES_EXTENDED_STRING_MODE)
+        return -101;
+    return encodeExtendedStringModeInternal(inVals, outVals, nValuesMax, nValuesOut, nPrimeVals, primeUniques, nPrimeUniques, maxBytes, 0);
+} // end encodeExtendedStringModePrimed
+
 static inline void dsmGetBits(const unsigned char *inVals, const uint32_t nBitsToGet, uint32_t *thisInVal, uint32_t *thisVal, uint32_t *bitPos, int32_t *theBits)
 {
     // get 1 to 8 bits from inVals into theBits
@@ -344,7 +443,7 @@ static inline void dsmGetBits2(const unsigned char *inVals, const uint32_t nBits
     return;
 } // end dsmGetBits2
 
-int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+static inline int32_t decodeExtendedStringModeInternal(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed, const uint32_t nPrimeVals, const unsigned char *primeUniques, const uint32_t nPrimeUniques)
 {
     uint32_t nextOutVal;
     uint32_t thisInVal; // position of encoded bits
@@ -365,7 +464,27 @@ int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
     // number uniques from first byte bits 3-7 plus first bit of first encoding byte
     // second bit of first encoding byte reserved for indicating whether uniques are compressed or not
     
-    if ((secondByte & 128) == 0)
+    if (nPrimeVals > 0)
+    {
+        // dictionary uniques precede the uniques in the input
+        if (nUniquesIn < nPrimeUniques)
+            return -22;
+        nUniquesIn -= nPrimeUniques;
+        memcpy(uncompressedUniques, primeUniques, nPrimeUniques);
+        pUniques = uncompressedUniques;
+        if ((secondByte & 128) == 0)
+        {
+            memcpy(uncompressedUniques+nPrimeUniques, inVals+2, nUniquesIn);
+            thisInVal = nUniquesIn + 2;
+        }
+        else
+        {
+            if (decode7bitsInternal(inVals+2, uncompressedUniques+nPrimeUniques, nUniquesIn, &thisInVal) != (int32_t)nUniquesIn)
+                return -21;
+            thisInVal += 2; // point past initial byte for encoded bytes
+        }
+    }
+    else if ((secondByte & 128) == 0)
     {
         // uniques are not compressed, point at input encoding
         pUniques = inVals+2;
@@ -383,23 +502,34 @@ int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
         thisInVal += 2; // point past initial byte for encoded bytes
     }
     uint32_t thisVal = inVals[thisInVal]; // current coded byte
-    // first value is always the first unique
-    outVals[0] = pUniques[0]; // first val is always first unique
-    // encoding bit for first two values in first bit of encoded bytes
-    if (thisVal & 1)
+    uint32_t nUniqueBits = 1; // current number uniques determines 1-6 bits used: 1 bit for 1 or 2 uniques to start;
+    if (nPrimeVals > 0)
     {
-        // second value matches first
-        outVals[1] = outVals[0];
-        nUniques = 1;
+        // dictionary values are already in outVals: decode from the first value following them
+        nUniques = nPrimeUniques;
+        nUniqueBits = encodingBits512[nPrimeUniques-1];
+        nextOutVal = nPrimeVals;
+        bitPos = 0;
     }
     else
     {
-        // second value is a unique
-        outVals[1] = pUniques[1];
-        nUniques = 2;
+        // first value is always the first unique
+        outVals[0] = pUniques[0]; // first val is always first unique
+        // encoding bit for first two values in first bit of encoded bytes
+        if (thisVal & 1)
+        {
+            // second value matches first
+            outVals[1] = outVals[0];
+            nUniques = 1;
+        }
+        else
+        {
+            // second value is a unique
+            outVals[1] = pUniques[1];
+            nUniques = 2;
+        }
+        nextOutVal=2; // start with third output value
     }
-    uint32_t nUniqueBits = 1; // current number uniques determines 1-6 bits used: 1 bit for 1 or 2 uniques to start;
-    nextOutVal=2; // start with third output value
     const uint32_t nOrigMinus1=nOriginalValues-1;
     while (nextOutVal < nOrigMinus1)
     {
@@ -453,10 +583,18 @@ int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
                     const uint32_t nPosBits = encodingBits512[nextOutVal];
                     dsmGetBits(inVals, nPosBits, &thisInVal, &thisVal, &bitPos, &theBits); // 8 bits
                 }
-                else
+                else if (nextOutVal < MAX_STRING_MODE_EXTENDED_VALUES)
                 {
                     dsmGetBits2(inVals, 9, &thisInVal, &thisVal, &bitPos, &theBits); // 9 bits
                 }
+                else
+                {
+                    // 10 to 13 bits following prime values: lower 8 bits first
+                    int32_t upperBits;
+                    dsmGetBits(inVals, 8, &thisInVal, &thisVal, &bitPos, &theBits);
+                    dsmGetBits(inVals, esmPositionBits(nextOutVal)-8, &thisInVal, &thisVal, &bitPos, &upperBits);
+                    theBits |= upperBits << 8;
+                }
                 uint32_t stringPos=(uint32_t)theBits;
                 assert((uint32_t)stringPos+stringLen <= nextOutVal);
                 assert(nextOutVal+stringLen <= nOriginalValues);
@@ -475,5 +613,19 @@ int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *out
     if (bitPos > 0)
         thisInVal++; // inc past partial input value
     *bytesProcessed = thisInVal;
-    return (int32_t)nOriginalValues;
+    return (int32_t)(nOriginalValues-nPrimeVals);
+} // end decodeExtendedStringModeInternal
+
+int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed)
+{
+    return decodeExtendedStringModeInternal(inVals, outVals, nOriginalValues, bytesProcessed, 0, NULL, 0);
 } // end decodeExtendedStringMode
+
+int32_t decodeExtendedStringModePrimed(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed, const uint32_t nPrimeVals, const unsigned char *primeUniques, const uint32_t nPrimeUniques)
+{
+    // outVals holds the nPrimeVals dictionary values used to encode; the
+    // decoded values follow them for nOriginalValues total
+    if (nPrimeVals == 0 || nPrimeVals >= nOriginalValues || nPrimeVals > MAX_STRING_MODE_PRIME_VALUES || nOriginalValues-nPrimeVals > MAX_STRING_MODE_EXTENDED_VALUES || nPrimeUniques == 0 || nPrimeUniques > MAX_UNIQUES_EXTENDED_STRING_MODE)
+        return -101;
+    return decodeExtendedStringModeInternal(inVals, outVals, nOriginalValues, bytesProcessed, nPrimeVals, primeUniques, nPrimeUniques);
+} // end decodeExtendedStringModePrimed
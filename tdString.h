@@ -29,6 +29,7 @@
 
 #define MAX_UNIQUES_EXTENDED_STRING_MODE 64
 #define MAX_TOTAL_UNIQUES_EXTENDED_STRING_MODE 128
+#define MAX_STRING_MODE_PRIME_VALUES 4096 // dictionary or stream window values preceding the values to encode
 // number of encoding bits needed for an index value from 0 to 511
 static const uint32_t encodingBits512[512]={1,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4,5,5,5,5,5,5,5,5,5,5,5,5,5,5,
     5,5,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
@@ -50,4 +51,7 @@ static const uint32_t encodingBits512[512]={1,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4,5,5,
 
 int32_t encodeExtendedStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut);
 int32_t decodeExtendedStringMode(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed);
+int32_t encodeExtendedStringModeMax(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut, const uint32_t maxBytes, const uint32_t sizeOnly);
+int32_t encodeExtendedStringModePrimed(const unsigned char *inVals, unsigned char *outVals, const uint32_t nValuesMax, uint32_t *nValuesOut, const uint32_t nPrimeVals, const unsigned char *primeUniques, const uint32_t nPrimeUniques, const uint32_t maxBytes);
+int32_t decodeExtendedStringModePrimed(const unsigned char *inVals, unsigned char *outVals, const uint32_t nOriginalValues, uint32_t *bytesProcessed, const uint32_t nPrimeVals, const unsigned char *primeUniques, const uint32_t nPrimeUniques);
 #endif /* tdString_h */
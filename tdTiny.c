@@ -0,0 +1,255 @@
+//
+//  tdTiny.c
+//  Bit packing of batches of values of 1 to 15 bytes, such as flags, enums and short codes,
+//  in one bitstream with td5 and td64 encodings that are not aligned to bytes.
+//
+//  Copyright © 2021-2022 L. Stevan Leonard. All rights reserved.
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tdTiny.h"
+#include "td512.h"
+#include <string.h>
+
+#define TINY_HEADER_BYTES 3 // number of values and the size of all values or 0
+#define TINY_MAX_TD5_VALUES 5 // td5 for 1 to 5 values, td64 for 6 or more
+
+static inline void tinyOutputBits(unsigned char *outVals, uint32_t *outputOffset, uint64_t *outBits, uint32_t *nOutBits, const uint32_t bits, const uint32_t nBits)
+{
+    // append nBits, 0 to 32, to the 64-bit output buffer
+    *outBits |= (uint64_t)bits << *nOutBits;
+    *nOutBits += nBits;
+    while (*nOutBits >= 8)
+    {
+        outVals[(*outputOffset)++] = (unsigned char)*outBits;
+        *outBits >>= 8;
+        *nOutBits -= 8;
+    }
+} // end tinyOutputBits
+
+static inline uint32_t tinyBitsFit(const uint32_t outputOffset, const uint32_t nOutBits, const uint32_t nBits, const uint32_t maxOutBytes)
+{
+    // 1 when nBits more bits and the bits not yet output fit in maxOutBytes
+    return outputOffset + (nOutBits + nBits + 7) / 8 <= maxOutBytes;
+} // end tinyBitsFit
+
+static inline uint64_t tinyLoadBits(const unsigned char *streamVals, const uint32_t nStreamBytes, const uint32_t bitPos)
+{
+    // 57 or more bits of the stream from bitPos, with 0 for bits past the end of the stream
+    const uint32_t byteIx=bitPos >> 3;
+    uint64_t bits=0;
+    if (byteIx + 8 <= nStreamBytes)
+        memcpy(&bits, streamVals+byteIx, 8);
+    else
+    {
+        uint32_t i;
+        for (i=0; byteIx+i < nStreamBytes && i < 8; i++)
+            bits |= (uint64_t)streamVals[byteIx+i] << (i*8);
+    }
+    return bits >> (bitPos & 7);
+} // end tinyLoadBits
+
+static inline void tinyCopyBits(const unsigned char *streamVals, const uint32_t nStreamBytes, uint32_t bitPos, unsigned char *outVals, const uint32_t nBytes)
+{
+    // copy nBytes bytes of the stream from bitPos to outVals, 7 bytes at a time
+    uint32_t i;
+    for (i=0; i<nBytes; i+=7)
+    {
+        const uint64_t bits=tinyLoadBits(streamVals, nStreamBytes, bitPos);
+        uint32_t j;
+        for (j=0; j<7 && i+j<nBytes; j++)
+            outVals[i+j] = (unsigned char)(bits >> (j*8));
+        bitPos += 56;
+    }
+} // end tinyCopyBits
+
+int32_t tdTinyEncode(const unsigned char *inVals, const uint32_t *valSizes, const uint32_t nVals, unsigned char *outVals, const uint32_t maxOutBytes)
+{
+    // inVals holds nVals values one after the other, with sizes of 1 to TDTINY_MAX_VALUE_BYTES in valSizes
+    // each value is output to one bitstream without byte alignment: a 1 bit followed by the td5 encoding of 1 to 5 values
+    // or the bytes of the td64 encoding of 6 or more values, else a 0 bit followed by the bytes of the value
+    // output: nVals (2 bytes), the size of all values or 0 followed by td512 of the sizes two to a byte,
+    // the number of bitstream bytes (2 bytes), then the bitstream
+    // returns the number of bytes output
+    unsigned char encodedVals[MAX_TD64_BYTES+2];
+    uint32_t outputOffset=TINY_HEADER_BYTES;
+    uint64_t outBits=0;
+    uint32_t nOutBits=0;
+    uint32_t i;
+
+    if (nVals == 0 || nVals > TDTINY_MAX_VALUES)
+        return -147;
+    for (i=0; i<nVals; i++)
+    {
+        if (valSizes[i] == 0 || valSizes[i] > TDTINY_MAX_VALUE_BYTES)
+            return -148;
+    }
+    if (maxOutBytes < TINY_HEADER_BYTES)
+        return -149; // output buffer too small
+    outVals[0] = (unsigned char)nVals;
+    outVals[1] = (unsigned char)(nVals >> 8);
+    outVals[2] = (unsigned char)valSizes[0];
+    for (i=1; i<nVals; i++)
+    {
+        if (valSizes[i] != valSizes[0])
+        {
+            // sizes differ: td512 of the sizes, which are output as 4-bit values
+            unsigned char sizeVals[TDTINY_MAX_VALUES/2];
+            const uint32_t nSizeVals=(nVals+1)/2;
+            int32_t retBytes;
+            uint32_t j;
+            memset(sizeVals, 0, nSizeVals);
+            for (j=0; j<nVals; j++)
+                sizeVals[j/2] |= (unsigned char)(valSizes[j] << ((j & 1) * 4));
+            if (outputOffset >= maxOutBytes)
+                return -149; // output buffer too small
+            if ((retBytes=td512_max(sizeVals, outVals+outputOffset, nSizeVals, maxOutBytes-outputOffset)) < 0)
+                return retBytes == -151 ? -149 : retBytes; // -149 for output buffer too small
+            outVals[2] = 0;
+            outputOffset += (uint32_t)retBytes;
+            break;
+        }
+    }
+    if (outputOffset + 2 > maxOutBytes)
+        return -149; // output buffer too small
+    const uint32_t streamOffset=outputOffset+2;
+    outputOffset = streamOffset;
+    for (i=0; i<nVals; i++)
+    {
+        const uint32_t valSize=valSizes[i];
+        int32_t retBits;
+        uint32_t j;
+        if (valSize <= TINY_MAX_TD5_VALUES)
+        {
+            retBits = td5(inVals, encodedVals, valSize);
+            if (retBits > 0 && (uint32_t)retBits < valSize*8)
+            {
+                // td5 encoding is at most 27 bits, and bytes past them are not written
+                const uint32_t td5Vals=encodedVals[0] | (uint32_t)encodedVals[1] << 8 | (uint32_t)encodedVals[2] << 16 | (uint32_t)encodedVals[3] << 24;
+                if (!tinyBitsFit(outputOffset, nOutBits, 1+(uint32_t)retBits, maxOutBytes))
+                    return -149; // output buffer too small
+                tinyOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 1, 1);
+                tinyOutputBits(outVals, &outputOffset, &outBits, &nOutBits, td5Vals & ((1u << retBits) - 1), (uint32_t)retBits);
+                inVals += valSize;
+                continue;
+            }
+        }
+        else
+        {
+            retBits = td64(inVals, encodedVals, valSize);
+            if (retBits < 0)
+                return retBits;
+            if (retBits > 0 && (uint32_t)(retBits+7)/8 < valSize)
+            {
+                // td64 decodes a whole number of bytes
+                if (!tinyBitsFit(outputOffset, nOutBits, 1+(uint32_t)(retBits+7)/8*8, maxOutBytes))
+                    return -149; // output buffer too small
+                tinyOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 1, 1);
+                for (j=0; j<(uint32_t)(retBits+7)/8; j++)
+                    tinyOutputBits(outVals, &outputOffset, &outBits, &nOutBits, encodedVals[j], 8);
+                inVals += valSize;
+                continue;
+            }
+        }
+        // value not compressed
+        if (!tinyBitsFit(outputOffset, nOutBits, 1+valSize*8, maxOutBytes))
+            return -149; // output buffer too small
+        tinyOutputBits(outVals, &outputOffset, &outBits, &nOutBits, 0, 1);
+        for (j=0; j<valSize; j++)
+            tinyOutputBits(outVals, &outputOffset, &outBits, &nOutBits, inVals[j], 8);
+        inVals += valSize;
+    }
+    if (nOutBits > 0)
+        outVals[outputOffset++] = (unsigned char)outBits;
+    outVals[streamOffset-2] = (unsigned char)(outputOffset-streamOffset);
+    outVals[streamOffset-1] = (unsigned char)((outputOffset-streamOffset) >> 8);
+    return (int32_t)outputOffset;
+} // end tdTinyEncode
+
+int32_t tdTinyDecode(const unsigned char *inVals, unsigned char *outVals, uint32_t *valSizes, uint32_t *totalBytesProcessed)
+{
+    // decode the values encoded by tdTinyEncode one after the other into outVals, with their sizes in valSizes
+    // the number of values is in the first two bytes of inVals, and outVals must hold the bytes of all the values
+    // returns the number of values
+    unsigned char encodedVals[TDTINY_MAX_VALUE_BYTES+2]; // room for td64d to read one value ahead
+    const uint32_t nVals=inVals[0] | (uint32_t)inVals[1] << 8;
+    uint32_t inputOffset=TINY_HEADER_BYTES;
+    uint32_t bitPos=0;
+    uint32_t i;
+
+    if (nVals == 0 || nVals > TDTINY_MAX_VALUES || inVals[2] > TDTINY_MAX_VALUE_BYTES)
+        return -150; // corrupt tiny values data
+    if (inVals[2] == 0)
+    {
+        // td512 of the sizes
+        unsigned char sizeVals[512]; // room for the values of any td512 block
+        uint32_t bytesProcessed;
+        const int32_t nSizeVals=td512d(inVals+inputOffset, sizeVals, &bytesProcessed);
+        if (nSizeVals < 0)
+            return nSizeVals;
+        if ((uint32_t)nSizeVals != (nVals+1)/2)
+            return -150; // corrupt tiny values data
+        for (i=0; i<nVals; i++)
+        {
+            valSizes[i] = (sizeVals[i/2] >> ((i & 1) * 4)) & 15;
+            if (valSizes[i] == 0)
+                return -150; // corrupt tiny values data
+        }
+        inputOffset += bytesProcessed;
+    }
+    else
+    {
+        for (i=0; i<nVals; i++)
+            valSizes[i] = inVals[2];
+    }
+    const uint32_t nStreamBytes=inVals[inputOffset] | (uint32_t)inVals[inputOffset+1] << 8;
+    const unsigned char *streamVals=inVals+inputOffset+2;
+    for (i=0; i<nVals; i++)
+    {
+        const uint32_t valSize=valSizes[i];
+        if ((tinyLoadBits(streamVals, nStreamBytes, bitPos++) & 1) == 0)
+        {
+            // value not compressed
+            tinyCopyBits(streamVals, nStreamBytes, bitPos, outVals, valSize);
+            bitPos += valSize*8;
+        }
+        else
+        {
+            uint32_t bytesProcessed;
+            int32_t retVals;
+            memset(encodedVals, 0, sizeof(encodedVals));
+            tinyCopyBits(streamVals, nStreamBytes, bitPos, encodedVals, valSize);
+            if (valSize <= TINY_MAX_TD5_VALUES)
+            {
+                retVals = td5d(encodedVals, outVals, valSize, &bytesProcessed);
+                bitPos += td5Bits(encodedVals, valSize);
+            }
+            else
+            {
+                retVals = td64d(encodedVals, outVals, valSize, &bytesProcessed);
+                bitPos += bytesProcessed*8;
+            }
+            if (retVals < 0)
+                return retVals;
+            if ((uint32_t)retVals != valSize)
+                return -150; // corrupt tiny values data
+        }
+        outVals += valSize;
+        if (bitPos > nStreamBytes*8)
+            return -150; // corrupt tiny values data
+    }
+    *totalBytesProcessed = inputOffset + 2 + nStreamBytes;
+    return (int32_t)nVals;
+} // end tdTinyDecode
@@ -0,0 +1,34 @@
+//
+//  tdTiny.h
+//  td512
+//
+//  Bit packing of batches of values of 1 to 15 bytes.
+//
+//  Copyright © 2021-2022 L. Stevan Leonard. All rights reserved.
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef tdTiny_h
+#define tdTiny_h
+
+#include <stdint.h>
+
+#define TDTINY_MAX_VALUES 1024 // values in one batch
+#define TDTINY_MAX_VALUE_BYTES 15 // bytes in one value
+
+int32_t tdTinyEncode(const unsigned char *inVals, const uint32_t *valSizes, const uint32_t nVals, unsigned char *outVals, const uint32_t maxOutBytes);
+int32_t tdTinyDecode(const unsigned char *inVals, unsigned char *outVals, uint32_t *valSizes, uint32_t *totalBytesProcessed);
+
+#endif /* tdTiny_h */
@@ -0,0 +1,223 @@
+//
+//  tdTrain.c
+//  Select dictionary values from sample records for td512LoadDictionary
+//  and text table characters and bigrams from sample text for td64RegisterTextTable
+//  and td64RegisterTextBigrams.
+//  Training is done offline and allocates working memory.
+//
+//  Copyright © 2021-2022 L. Stevan Leonard. All rights reserved.
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tdTrain.h"
+#include "td512.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRAIN_DMER_LENGTH 6 // length of the strings counted across samples
+#define TRAIN_SEGMENT_LENGTH 32 // length of the sample strings copied to the dictionary
+#define TRAIN_HASH_BITS 16
+
+static inline uint32_t trainHash(const unsigned char *vals)
+{
+    // hash TRAIN_DMER_LENGTH values
+    uint64_t dmer=0;
+    uint32_t i;
+    for (i=0; i<TRAIN_DMER_LENGTH; i++)
+        dmer |= (uint64_t)vals[i] << (i*8);
+    return (uint32_t)((dmer * 0x9E3779B97F4A7C15llu) >> (64-TRAIN_HASH_BITS));
+} // end trainHash
+
+int32_t td512TrainDictionary(const unsigned char *samples, const uint32_t *sampleSizes, const uint32_t nSamples, unsigned char *dictVals, const uint32_t maxDictVals)
+{
+    // samples holds nSamples records one after the other, with sizes in sampleSizes
+    // each TRAIN_DMER_LENGTH string is scored by the number of samples it occurs in;
+    // the TRAIN_SEGMENT_LENGTH sample string with the highest total score is
+    // added to the dictionary and its strings no longer score, until no scoring
+    // strings remain or maxDictVals is reached
+    // returns the number of dictionary values
+    uint32_t *dmerCount;
+    uint32_t *dmerSample; // last sample counted for a hash
+    uint32_t *dmerHash; // hash for each position of samples
+    uint32_t nTotalVals=0;
+    uint32_t nDictVals=0;
+    uint32_t i;
+    
+    if (maxDictVals == 0 || maxDictVals > TD512_MAX_DICTIONARY_VALUES || nSamples == 0)
+        return -134;
+    for (i=0; i<nSamples; i++)
+        nTotalVals += sampleSizes[i];
+    if (nTotalVals < TRAIN_DMER_LENGTH)
+        return -134;
+    dmerCount = (uint32_t *)calloc(1u << TRAIN_HASH_BITS, sizeof(uint32_t));
+    dmerSample = (uint32_t *)calloc(1u << TRAIN_HASH_BITS, sizeof(uint32_t));
+    dmerHash = (uint32_t *)malloc(nTotalVals * sizeof(uint32_t));
+    if (dmerCount == NULL || dmerSample == NULL || dmerHash == NULL)
+    {
+        free(dmerCount);
+        free(dmerSample);
+        free(dmerHash);
+        return -135;
+    }
+    uint32_t sampleOffset=0;
+    for (i=0; i<nSamples; i++)
+    {
+        uint32_t pos;
+        for (pos=0; pos+TRAIN_DMER_LENGTH<=sampleSizes[i]; pos++)
+        {
+            const uint32_t hash=trainHash(samples+sampleOffset+pos);
+            dmerHash[sampleOffset+pos] = hash;
+            if (dmerSample[hash] != i+1)
+            {
+                // count once per sample
+                dmerSample[hash] = i+1;
+                dmerCount[hash]++;
+            }
+        }
+        sampleOffset += sampleSizes[i];
+    }
+    while (nDictVals < maxDictVals)
+    {
+        uint32_t bestScore=0;
+        uint32_t bestOffset=0;
+        uint32_t bestLength=0;
+        sampleOffset = 0;
+        for (i=0; i<nSamples; i++)
+        {
+            const uint32_t sampleSize=sampleSizes[i];
+            const uint32_t segmentLength=sampleSize < TRAIN_SEGMENT_LENGTH ? sampleSize : TRAIN_SEGMENT_LENGTH;
+            if (segmentLength >= TRAIN_DMER_LENGTH)
+            {
+                // score of the segment at pos is the sum of the counts of the dmers that start in it
+                const uint32_t nSegmentDmers=segmentLength-TRAIN_DMER_LENGTH+1;
+                uint32_t score=0;
+                uint32_t pos;
+                for (pos=0; pos<nSegmentDmers; pos++)
+                    score += dmerCount[dmerHash[sampleOffset+pos]];
+                for (pos=0; ; pos++)
+                {
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestOffset = sampleOffset + pos;
+                        bestLength = segmentLength;
+                    }
+                    if (pos+segmentLength >= sampleSize)
+                        break;
+                    score += dmerCount[dmerHash[sampleOffset+pos+nSegmentDmers]] - dmerCount[dmerHash[sampleOffset+pos]];
+                }
+            }
+            sampleOffset += sampleSize;
+        }
+        if (bestScore <= bestLength-TRAIN_DMER_LENGTH+1)
+            break; // remaining strings occur in one sample at most
+        if (bestLength > maxDictVals-nDictVals)
+            bestLength = maxDictVals-nDictVals;
+        memcpy(dictVals+nDictVals, samples+bestOffset, bestLength);
+        nDictVals += bestLength;
+        for (i=0; i+TRAIN_DMER_LENGTH<=bestLength; i++)
+            dmerCount[dmerHash[bestOffset+i]] = 0; // strings in the dictionary no longer score
+    }
+    free(dmerCount);
+    free(dmerSample);
+    free(dmerHash);
+    return (int32_t)nDictVals;
+} // end td512TrainDictionary
+
+int32_t td64TrainTextTable(const unsigned char *samples, const uint32_t nSampleVals, unsigned char *textChars)
+{
+    // text mode codes are 3 bits for the first two table characters, 4 bits for
+    // the next two, 5 bits for the next 15 and 7 bits for the last four, so
+    // ordering the most frequent characters first minimizes encoded bits
+    // returns TD64_TEXT_TABLE_CHARS; unused positions are filled with values not in samples
+    uint32_t charCount[256]={0};
+    uint8_t charUsed[256]={0};
+    uint32_t i;
+    uint32_t j;
+    
+    if (nSampleVals == 0)
+        return -134;
+    for (i=0; i<nSampleVals; i++)
+        charCount[samples[i]]++;
+    for (i=0; i<TD64_TEXT_TABLE_CHARS; i++)
+    {
+        uint32_t bestChar=0;
+        uint32_t bestCount=0;
+        for (j=0; j<256; j++)
+        {
+            if (charUsed[j] == 0 && charCount[j] > bestCount)
+            {
+                bestCount = charCount[j];
+                bestChar = j;
+            }
+        }
+        if (bestCount == 0)
+        {
+            // fewer than TD64_TEXT_TABLE_CHARS distinct values
+            for (bestChar=0; charUsed[bestChar]; bestChar++)
+                ;
+        }
+        charUsed[bestChar] = 1;
+        textChars[i] = (unsigned char)bestChar;
+    }
+    return TD64_TEXT_TABLE_CHARS;
+} // end td64TrainTextTable
+
+int32_t td64TrainTextBigrams(const unsigned char *samples, const uint32_t nSampleVals, unsigned char *bigrams)
+{
+    // bigram text mode codes are 6 bits for the first 5 bigrams, 7 bits for the next 9 and 8 bits for the last 2,
+    // so the most frequent pairs of values are ordered first
+    // returns TD64_TEXT_BIGRAMS; unused positions are filled with pairs not in samples
+    uint32_t *pairCount;
+    uint32_t i;
+    uint32_t j;
+    
+    if (nSampleVals < 2)
+        return -134;
+    pairCount = (uint32_t *)calloc(65536, sizeof(uint32_t));
+    if (pairCount == NULL)
+        return -135;
+    for (i=0; i+1<nSampleVals; i++)
+        pairCount[samples[i] | ((uint32_t)samples[i+1] << 8)]++;
+    for (i=0; i<TD64_TEXT_BIGRAMS; i++)
+    {
+        uint32_t bestPair=0;
+        uint32_t bestCount=0;
+        for (j=0; j<65536; j++)
+        {
+            if (pairCount[j] > bestCount)
+            {
+                bestCount = pairCount[j];
+                bestPair = j;
+            }
+        }
+        if (bestCount == 0)
+        {
+            // fewer than TD64_TEXT_BIGRAMS distinct pairs: counts of used pairs are 0, so skip those chosen
+            for (bestPair=0; ; bestPair++)
+            {
+                for (j=0; j<i && (bigrams[j*2] | ((uint32_t)bigrams[j*2+1] << 8)) != bestPair; j++)
+                    ;
+                if (j == i && pairCount[bestPair] == 0)
+                    break;
+            }
+        }
+        pairCount[bestPair] = 0; // not chosen again
+        bigrams[i*2] = (unsigned char)bestPair;
+        bigrams[i*2+1] = (unsigned char)(bestPair >> 8);
+    }
+    free(pairCount);
+    return TD64_TEXT_BIGRAMS;
+} // end td64TrainTextBigrams
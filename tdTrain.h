@@ -0,0 +1,32 @@
+//
+//  tdTrain.h
+//  td512
+//
+//  Offline training of data used by td512 contexts.
+//
+//  Copyright © 2021-2022 L. Stevan Leonard. All rights reserved.
+/*
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef tdTrain_h
+#define tdTrain_h
+
+#include <stdint.h>
+
+int32_t td512TrainDictionary(const unsigned char *samples, const uint32_t *sampleSizes, const uint32_t nSamples, unsigned char *dictVals, const uint32_t maxDictVals);
+int32_t td64TrainTextTable(const unsigned char *samples, const uint32_t nSampleVals, unsigned char *textChars);
+int32_t td64TrainTextBigrams(const unsigned char *samples, const uint32_t nSampleVals, unsigned char *bigrams);
+
+#endif /* tdTrain_h */